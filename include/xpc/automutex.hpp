@@ -27,14 +27,16 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2024-04-15
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  This module defines the following classes:
  *
- *      -   xpc::mutex.  An alias for std::recursive_mutex.
- *      -   xpc::automutex. A way to lock a function exception-safely and
- *          easily.
+ *      -   xpc::autolock<MUTEX>.  A way to lock a function exception-safely
+ *          and easily, with any mutex offering lock() and unlock(), such as
+ *          xpc::recmutex or xpc::queuemutex.
+ *      -   xpc::automutex. An alias for autolock<recmutex>, the original
+ *          (and still most common) usage.
  */
 
 #include "xpc/recmutex.hpp"             /* xpc::recmutex wrapper class      */
@@ -55,9 +57,12 @@ namespace xpc
  *  It could potentially be replaced by std::lock_guard<std::recursive_mutex>
  *  However, it provides lock() and unlock() functions for extra flexibility
  *  and danger.  :-)
+ *
+ *  The MUTEX type needs only lock() and unlock() member functions.
  */
 
-class automutex
+template <typename MUTEX>
+class autolock
 {
 
 private:
@@ -66,13 +71,13 @@ private:
      *  Provides the mutex reference to be used for locking.
      */
 
-    recmutex & m_safety_mutex;
+    MUTEX & m_safety_mutex;
 
 private:                        /* do not allow these functions to be used  */
 
-    automutex () = delete;
-    automutex (const automutex &) = delete;
-    automutex & operator = (const automutex &) = delete;
+    autolock () = delete;
+    autolock (const autolock &) = delete;
+    autolock & operator = (const autolock &) = delete;
 
 public:
 
@@ -84,7 +89,7 @@ public:
      *      The caller's mutex to be used for locking.
      */
 
-    automutex (recmutex & my_mutex) : m_safety_mutex (my_mutex)
+    autolock (MUTEX & my_mutex) : m_safety_mutex (my_mutex)
     {
         lock();
     }
@@ -93,7 +98,7 @@ public:
      *  The destructor unlocks the mutex.
      */
 
-    ~automutex ()
+    ~autolock ()
     {
         unlock();
     }
@@ -113,7 +118,13 @@ public:
         m_safety_mutex.unlock();
     }
 
-};          // class automutex
+};          // class autolock<MUTEX>
+
+/**
+ *  The usual guard, for a recmutex.
+ */
+
+using automutex = autolock<recmutex>;
 
 #if defined PLATFORM_DEBUG
 extern bool thread_1_locking ();
@@ -0,0 +1,174 @@
+#if ! defined XPC66_XPC_BARRIER_HPP
+#define XPC66_XPC_BARRIER_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          barrier.hpp
+ *
+ *  This module declares a reusable (cyclic) barrier and a one-shot latch,
+ *  for worker threads that process blocks of audio or MIDI in phases.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Both are like their C++20 namesakes, which we cannot use with C++14.
+ *  Waiting threads spin briefly (on multi-processor machines), since the
+ *  last thread of a phase is often only microseconds behind, and then sleep
+ *  in futex_wait().  The thread that completes the phase makes the
+ *  futex_wake() call only if somebody went to sleep.
+ *
+\verbatim
+        xpc::barrier phase(workers, [&] { swap_buffers(); });
+        ... in each worker ...
+        for (;;)
+        {
+            process_my_share();
+            phase.arrive_and_wait();            // swap_buffers() runs once
+        }
+\endverbatim
+ */
+
+#include <atomic>                       /* std::atomic<int>                 */
+#include <functional>                   /* std::function<>                  */
+
+#include "xpc/cpu_hints.hpp"            /* xpc::c_cache_line_size           */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A barrier for a fixed number of threads, usable for any number of
+ *  phases.
+ */
+
+class barrier
+{
+
+public:
+
+    using completion = std::function<void ()>;
+
+private:
+
+    /**
+     *  The number of threads taking part.
+     */
+
+    const int m_count;
+
+    /**
+     *  Run by the last thread to arrive, before any thread is released.
+     */
+
+    completion m_completion;
+
+    /**
+     *  Threads arrived in the current phase.  It is written by every thread,
+     *  so it gets its own cache line, apart from the phase word that the
+     *  waiters spin on.
+     */
+
+    alignas(c_cache_line_size) std::atomic<int> m_arrived;
+
+    /**
+     *  The phase number, which is also the futex word.
+     */
+
+    alignas(c_cache_line_size) std::atomic<int> m_phase;
+
+    /**
+     *  The number of threads asleep, or about to sleep, on m_phase.
+     */
+
+    std::atomic<int> m_sleepers;
+
+public:
+
+    explicit barrier (int count, completion c = completion());
+    barrier (const barrier &) = delete;
+    barrier & operator = (const barrier &) = delete;
+    ~barrier () = default;
+
+    bool arrive_and_wait ();
+
+    int count () const
+    {
+        return m_count;
+    }
+
+    int phase () const
+    {
+        return m_phase.load(std::memory_order_acquire);
+    }
+
+};          // class barrier
+
+/**
+ *  A single-use count-down latch.  Threads wait until the count reaches
+ *  zero.  Unlike a barrier, the threads that count down need not wait.
+ */
+
+class latch
+{
+
+private:
+
+    /**
+     *  The remaining count, which is also the futex word.
+     */
+
+    std::atomic<int> m_count;
+
+    std::atomic<int> m_sleepers;
+
+public:
+
+    explicit latch (int count);
+    latch (const latch &) = delete;
+    latch & operator = (const latch &) = delete;
+    ~latch () = default;
+
+    void count_down (int n = 1);
+    void wait ();
+    void arrive_and_wait (int n = 1);
+
+    bool try_wait () const
+    {
+        return m_count.load(std::memory_order_acquire) <= 0;
+    }
+
+};          // class latch
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_BARRIER_HPP
+
+/*
+ * barrier.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,216 @@
+#if ! defined XPC66_XPC_BIASEDMUTEX_HPP
+#define XPC66_XPC_BIASEDMUTEX_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          biasedmutex.hpp
+ *
+ *  This module declares a lock biased towards one "owner" thread, for data
+ *  that the real-time thread touches nearly all of the time and the GUI
+ *  thread touches now and then.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Even an uncontended recmutex costs an atomic read-modify-write to lock
+ *  and another to unlock.  Here the owner's fast path is a plain store of a
+ *  "busy" flag, a compiler barrier, and a plain load of a "revoked" flag;
+ *  unlocking is another plain store.  There are no atomic instructions and
+ *  no hardware fences on x86.
+ *
+ *  The other ("guest") threads pay for that.  A guest takes an internal
+ *  mutex, sets the revoked flag, and then calls the Linux membarrier()
+ *  system call, which forces a full memory barrier on every running thread
+ *  of the process.  After that, the owner either has seen the revoked flag,
+ *  or its busy flag is visible to the guest, which waits for it to clear.
+ *  This is the asymmetric form of Dekker's algorithm.  membarrier() costs
+ *  microseconds, so this lock fits only when guests are rare.
+ *
+ *  Where membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED) is not available
+ *  (older kernels, other platforms), both sides use a sequentially
+ *  consistent fence instead.  That is still correct, and still cheaper for
+ *  the owner than a mutex, but the owner then pays for one fence per lock.
+ *
+ *  Exactly one thread may use owner_lock(), and it must not also use
+ *  lock().  Any thread may use lock(), so guests can use autolock<>:
+ *
+\verbatim
+        xpc::biasedmutex m_mix_mutex;
+        ... in the real-time thread, every cycle ...
+        xpc::autoownerlock guard{m_mix_mutex};
+        ... in the GUI thread, once in a while ...
+        xpc::autolock<xpc::biasedmutex> guard{m_mix_mutex};
+\endverbatim
+ */
+
+#include <atomic>                       /* std::atomic<int>, fences         */
+#include <mutex>                        /* std::mutex                       */
+
+#include "xpc/cpu_hints.hpp"            /* xpc::c_cache_line_size           */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A lock that is nearly free for its owner thread and expensive for all
+ *  the others.
+ */
+
+class biasedmutex
+{
+
+private:
+
+    /**
+     *  Set by the owner while it holds the lock via the fast path.  Only
+     *  the owner writes it.
+     */
+
+    alignas(c_cache_line_size) std::atomic<int> m_owner_busy;
+
+    /**
+     *  Set when the owner had to take the slow path, so that owner_unlock()
+     *  knows to release the guest mutex.  Only the owner uses it.
+     */
+
+    bool m_owner_slow;
+
+    /**
+     *  Set by a guest while it wants or holds the lock.
+     */
+
+    alignas(c_cache_line_size) std::atomic<int> m_revoked;
+
+    /**
+     *  Serializes the guests, and the owner when it has to take the slow
+     *  path.
+     */
+
+    std::mutex m_guest_mutex;
+
+    /**
+     *  True if membarrier() works here, so that the owner needs only a
+     *  compiler barrier.  Copied from a process-wide check at construction,
+     *  so that the fast path need not test a function-local static.
+     */
+
+    const bool m_asymmetric;
+
+public:
+
+    biasedmutex ();
+    biasedmutex (const biasedmutex &) = delete;
+    biasedmutex & operator = (const biasedmutex &) = delete;
+    ~biasedmutex () = default;
+
+    /**
+     *  Locks for the owner thread.  If no guest has asked for the lock,
+     *  this is two plain memory accesses.
+     */
+
+    void owner_lock ()
+    {
+        m_owner_busy.store(1, std::memory_order_relaxed);
+        if (m_asymmetric)
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        else
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (m_revoked.load(std::memory_order_acquire) != 0)
+            owner_lock_slow();
+    }
+
+    void owner_unlock ()
+    {
+        if (m_owner_slow)
+        {
+            m_owner_slow = false;
+            m_guest_mutex.unlock();
+        }
+        else
+            m_owner_busy.store(0, std::memory_order_release);
+    }
+
+    void lock ();
+    void unlock ();
+    bool try_lock ();
+
+    bool asymmetric () const
+    {
+        return m_asymmetric;
+    }
+
+    static bool membarrier_available ();
+
+private:
+
+    void owner_lock_slow ();
+    void serialize ();
+
+};          // class biasedmutex
+
+/**
+ *  Takes the owner's side of a biasedmutex for the life of the guard, in
+ *  the manner of automutex.  Guests use autolock<biasedmutex>.
+ */
+
+class autoownerlock
+{
+
+private:
+
+    biasedmutex & m_safety_mutex;
+
+private:                        /* do not allow these functions to be used  */
+
+    autoownerlock () = delete;
+    autoownerlock (const autoownerlock &) = delete;
+    autoownerlock & operator = (const autoownerlock &) = delete;
+
+public:
+
+    autoownerlock (biasedmutex & my_mutex) : m_safety_mutex (my_mutex)
+    {
+        m_safety_mutex.owner_lock();
+    }
+
+    ~autoownerlock ()
+    {
+        m_safety_mutex.owner_unlock();
+    }
+
+};          // class autoownerlock
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_BIASEDMUTEX_HPP
+
+/*
+ * biasedmutex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
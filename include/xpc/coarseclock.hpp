@@ -0,0 +1,140 @@
+#if ! defined XPC66_XPC_COARSECLOCK_HPP
+#define XPC66_XPC_COARSECLOCK_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          coarseclock.hpp
+ *
+ *  This module declares cheap, low-resolution clocks, for log tags,
+ *  timeouts, and the like.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Two levels:
+ *
+ *      -   coarse_nanotime() and coarse_millitime() read
+ *          CLOCK_MONOTONIC_COARSE in Linux, the time of the last timer
+ *          tick (1 to 4 ms resolution, per coarse_resolution_ns()).  It
+ *          needs no hardware counter read, so it is several times cheaper
+ *          than nanotime().  Elsewhere they call nanotime().
+ *      -   cached_clock::nanotime() and cached_clock::millitime() read a
+ *          timestamp that a background thread, started by
+ *          cached_clock::start(), refreshes every millisecond (by default).
+ *          A read is one relaxed atomic load.
+ *
+ *  Both are on the nanotime() scale, so values can be compared with it
+ *  to within the resolution.  A timeout check in a tight loop becomes
+ *  essentially free:
+ *
+\verbatim
+        xpc::cached_clock::start();
+        std::int64_t deadline = xpc::cached_clock::millitime() + 500;
+        while (! done())
+        {
+            if (xpc::cached_clock::millitime() >= deadline)
+                break;                          // timed out
+            ...
+        }
+\endverbatim
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <cstdint>                      /* std::int64_t                     */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+extern std::int64_t coarse_nanotime ();
+extern std::int64_t coarse_millitime ();
+extern std::int64_t coarse_resolution_ns ();
+
+/**
+ *  A process-wide timestamp kept fresh by a background thread.  All of the
+ *  members are static.
+ */
+
+class cached_clock
+{
+
+private:
+
+    /**
+     *  The latest timestamp, on the nanotime() scale, or 0 if the updater
+     *  thread is not running.
+     */
+
+    static std::atomic<std::int64_t> sm_nanotime;
+
+public:
+
+    cached_clock () = delete;
+
+    static bool start (int period_us = 1000);
+    static void stop ();
+
+    static bool running ()
+    {
+        return sm_nanotime.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     *  Gets the cached time.  If the updater is not running, it falls back
+     *  to coarse_nanotime().
+     */
+
+    static std::int64_t nanotime ()
+    {
+        std::int64_t t = sm_nanotime.load(std::memory_order_relaxed);
+        return t != 0 ? t : coarse_nanotime() ;
+    }
+
+    static std::int64_t millitime ()
+    {
+        return nanotime() / 1000000;
+    }
+
+private:
+
+    friend class clock_updater;
+
+    static void update (std::int64_t t)
+    {
+        sm_nanotime.store(t, std::memory_order_relaxed);
+    }
+
+};          // class cached_clock
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_COARSECLOCK_HPP
+
+/*
+ * coarseclock.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
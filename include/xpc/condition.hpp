@@ -28,7 +28,7 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2024-01-15
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  This module defines the class xpc::condition_var, which provides a common
@@ -38,9 +38,13 @@
  *  2019-04-21 Reverted to commit 5b125f71 to stop GUI deadlock :-(
  */
 
+#include <chrono>                       /* std::chrono::steady_clock      */
+#include <atomic>                       /* std::atomic<int>               */
 #include <condition_variable>           /* for xpc::synchronizer class    */
+#include <memory>                       /* std::unique_ptr<>              */
 
 #include "xpc/recmutex.hpp"             /* xpc::recmutex wrapper class    */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_token                */
 
 /*
  *  Do not document a namespace; it breaks Doxygen.
@@ -52,8 +56,16 @@ namespace xpc
 /**
  *  A mutex works best in conjunction with a condition variable.  The "has-a"
  *  relationship is more logical than an "is-a" relationship.  Note the
- *  additional member function condition::wait_on_predicate(), which allow the
- *  usage of a test function returning a boolean.
+ *  additional member function template wait(pred), which allows the usage of
+ *  a test function returning a boolean.
+ *
+ *  Each condition has its own condition variable, so signal() and
+ *  broadcast() wake only threads waiting on this condition.  As with any
+ *  condition variable, wait() can return spuriously; wait(pred) handles
+ *  that.  The timed waits use absolute monotonic deadlines, and return true
+ *  on a timeout.  All of the wait functions must be called with the condition
+ *  locked exactly once (the recursive mutex is released only one level by
+ *  the wait).
  */
 
 class condition
@@ -68,20 +80,12 @@ private:
 
     class impl;
 
-    /**
-     *  Provides a recursive mutex that can be used by the whole application,
-     *  and is.
-     */
-
-    static recmutex sm_recursive_mutex;
-
     /**
      *  Our recursive mutex (not the normal C++11 non-recursive mutex) used
      *  for locking the conditional wait operation.  We use our own automutex,
      *  not the recursive mkutex that std::unique_lock<> require.  Provides a
-     *  mutex lock usable by a single module or class.  However, this mutex
-     *  ends up being a copy of the static sm_recursive_mutex (and, of course,
-     *  a different "object").
+     *  mutex lock usable by a single module or class.  (The old static
+     *  "application-wide" mutex is gone; see xpc::global_stripes().)
      */
 
     mutable recmutex m_mutex_lock;
@@ -118,8 +122,46 @@ public:
     }
 
     void signal ();
+    void broadcast ();
     void wait ();
-    void wait (int ms);
+    bool wait (int ms);
+    bool wait_until (std::chrono::steady_clock::time_point deadline);
+    bool wait (const stop_token & token);
+
+    /**
+     *  Waits until the predicate returns true.  The caller must hold the
+     *  lock, and whoever changes the state tested by the predicate must also
+     *  change it while holding the lock, then call signal() or broadcast().
+     *
+     * \param pred
+     *      A callable taking no arguments and returning a bool.
+     */
+
+    template <typename PREDICATE>
+    void wait (PREDICATE pred)
+    {
+        while (! pred())
+            wait();
+    }
+
+    /**
+     *  Waits until the predicate returns true, or a stop is requested.
+     *
+     * \return
+     *      Returns the value of the predicate, which is false if the wait
+     *      ended because of the stop.
+     */
+
+    template <typename PREDICATE>
+    bool wait (PREDICATE pred, const stop_token & token)
+    {
+        while (! pred())
+        {
+            if (! wait(token))
+                return pred();
+        }
+        return true;
+    }
 
 };          // class condition
 
@@ -129,6 +171,21 @@ public:
  * --------------------------------------------------------------------------
  */
 
+/**
+ *  A condition variable, its mutex, and a predicate supplied by a derived
+ *  class.  By default signal() locks the mutex and notifies every time,
+ *  so predicate() may test any state that the signaller changes before
+ *  calling signal().
+ *
+ *  A derived class can pass true for "atomic_predicate" to the
+ *  constructor.  Then signal(), signal_all(), and flush() skip the lock
+ *  and the notify when no thread is waiting, which costs one atomic load.
+ *  That is correct only if every piece of state that predicate() tests is
+ *  a std::atomic written with the default (sequentially consistent)
+ *  memory order before signal() is called.  A plain or relaxed flag can
+ *  then lose a wakeup, and the waiter hangs.
+ */
+
 class synchronizer
 {
 
@@ -147,16 +204,66 @@ private:
 
     std::condition_variable m_condition_var;
 
+    /**
+     *  If true, the caller promises that predicate() tests only seq_cst
+     *  atomics, so that signal() can skip the lock when nobody waits.
+     */
+
+    const bool m_atomic_predicate;
+
+    /**
+     *  The number of threads inside one of the wait functions.  With an
+     *  atomic predicate, signal() does nothing but read it when it is zero.
+     */
+
+    std::atomic<int> m_waiters;
+
+    /**
+     *  Signals not yet passed on to the waiters, when batching.
+     */
+
+    std::atomic<int> m_pending;
+
+    /**
+     *  The steady-clock time, in microseconds, of the first pending signal.
+     */
+
+    std::atomic<long long> m_pending_since;
+
+    /**
+     *  Batching parameters.  A count of 1 or less means no batching.  Set
+     *  them (via set_batching()) before any thread waits or signals.
+     */
+
+    int m_batch_count;
+    int m_batch_us;
+
 public:
 
-    synchronizer ();
+    explicit synchronizer (bool atomic_predicate = false);
     synchronizer (const synchronizer &) = delete;
     synchronizer & operator = (synchronizer &&) = delete;
     synchronizer & operator = (const synchronizer &) = delete;
     virtual ~synchronizer () = default;
 
     bool wait ();
+    bool wait (const stop_token & token);
+    bool wait_for (int us);
+    bool wait_until (std::chrono::steady_clock::time_point deadline);
     void signal ();
+    void signal_all ();
+    void flush ();
+    void set_batching (int count, int us);
+
+    int waiters () const
+    {
+        return m_waiters.load();
+    }
+
+    bool atomic_predicate () const
+    {
+        return m_atomic_predicate;
+    }
 
     /**
      * The user of this class must derive a class to properly define this
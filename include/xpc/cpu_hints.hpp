@@ -0,0 +1,108 @@
+#if ! defined XPC66_XPC_CPU_HINTS_HPP
+#define XPC66_XPC_CPU_HINTS_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          cpu_hints.hpp
+ *
+ *  This module provides small processor-level helpers for spin loops and
+ *  data layout.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  These are header-only, since they must inline into the spin loops that
+ *  use them.
+ */
+
+#include <atomic>                       /* std::atomic_signal_fence()       */
+#include <cstddef>                      /* std::size_t                      */
+#include <thread>                       /* std::thread::hardware_concurrency*/
+
+#include "platform_macros.h"            /* pick the compiler and platform   */
+
+#if defined PLATFORM_MSVC
+#include <intrin.h>                     /* _mm_pause(), __yield()           */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  The assumed size of a cache line.  64 bytes is right for x86-64 and for
+ *  most ARM cores.  Objects written by different threads should be at least
+ *  this far apart to avoid "false sharing".  (C++17 offers
+ *  std::hardware_destructive_interference_size, but we support C++14.)
+ */
+
+const std::size_t c_cache_line_size = 64;
+
+/**
+ *  Tells the processor that the caller is in a spin-wait loop.  On x86 the
+ *  "pause" instruction saves power, gives a hyperthreaded sibling more of
+ *  the core, and avoids a memory-order pipeline flush when the loop exits.
+ *  Where there is no such instruction, this is just a compiler barrier, so
+ *  that the loop still re-reads memory.
+ */
+
+inline void
+cpu_relax ()
+{
+#if defined __x86_64__ || defined __i386__
+    __builtin_ia32_pause();
+#elif defined __aarch64__ || defined __arm__
+    __asm__ __volatile__ ("yield" ::: "memory");
+#elif defined PLATFORM_MSVC && (defined _M_X64 || defined _M_IX86)
+    _mm_pause();
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ *  Spinning while waiting for another thread only makes sense if that
+ *  thread can run at the same time.  On a single processor it just burns
+ *  the time slice the other thread needs, so spin-then-sleep waits should
+ *  go straight to sleep.
+ */
+
+inline bool
+spin_worthwhile ()
+{
+    static const bool s_multicore = std::thread::hardware_concurrency() > 1;
+    return s_multicore;
+}
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_CPU_HINTS_HPP
+
+/*
+ * cpu_hints.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
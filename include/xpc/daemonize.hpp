@@ -23,7 +23,7 @@
  * \file          daemonize.hpp
  * \author        Chris Ahlstrom
  * \date          2005-07-03 to 2007-08-21 (from xpc-suite project)
- * \updates       2024-04-17
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *    Daemonization of POSIX C Wrapper (PSXC) library
@@ -148,6 +148,27 @@ extern void signal_for_exit ();
 extern void signal_for_restart ();
 extern void signal_end_restart ();
 
+/*
+ *  A stop token that signal_for_exit(), SIGINT, and SIGTERM trigger, so
+ *  that threads sleeping or waiting with it wake at once.  Its
+ *  get_waitable() lets a thread wait for shutdown in wait_any().
+ *
+ *  In Linux the signal handler does the async-signal-safe part of the
+ *  stop, which wakes the token sleeps and its waitable; the stop
+ *  callbacks, which wake condition::wait(token) and
+ *  synchronizer::wait(token), run at the next session_close().  Elsewhere
+ *  the handler cannot safely touch the token, and the whole stop happens
+ *  at the next session_close().
+ *
+ *  A stop cannot be undone, so after one, session_setup() (as for a
+ *  restart) gives the session a new source; call session_stop_token()
+ *  again to get its token.
+ */
+
+class stop_token;
+
+extern stop_token session_stop_token ();
+
 }        // namespace xpc
 
 #endif   // XPC66_XPC_DAEMONIZE_HPP
@@ -0,0 +1,84 @@
+#if ! defined XPC66_XPC_FASTCLOCK_HPP
+#define XPC66_XPC_FASTCLOCK_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          fastclock.hpp
+ *
+ *  This module declares an optional fast clock, based on the processor's
+ *  time-stamp counter (TSC), for hot-path timestamps.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Even through the vDSO, clock_gettime() costs 20 to 30 ns or more.  On a
+ *  processor with an "invariant" TSC (one that ticks at a constant rate in
+ *  all power states, and is synchronized across cores), reading the counter
+ *  and scaling it costs far less.  fastclock_ns() returns the same kind
+ *  of value as nanotime(), so the two can be mixed:
+ *
+ *      ns = ns_base + ((tsc - tsc_base) * mult) >> shift
+ *
+ *  fastclock_init() checks for an invariant TSC (and, in Linux, that the
+ *  kernel has not rejected the TSC as a clock source), then calibrates it
+ *  against nanotime().  The calibration is refreshed about once a second,
+ *  by whichever caller first notices it is due, and any error found is
+ *  slewed out over the next second rather than stepped.  The parameters
+ *  are published through a seqlock.
+ *
+ *  A thread that read the old parameters just before a recalibration can
+ *  get a later value than one that reads the new ones just after it, so
+ *  each thread clamps its readings to the last value it returned.  Within
+ *  a thread the clock never runs backwards; across threads, readings taken
+ *  around a recalibration may be out of order by up to the error it
+ *  absorbs (normally well under a microsecond).
+ *
+ *  Without fastclock_init(), or without a usable TSC (e.g. non-x86
+ *  processors), fastclock_ns() just calls nanotime().
+ */
+
+#include <cstdint>                      /* std::int64_t                     */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+extern bool fastclock_init (bool enable = true);
+extern bool fastclock_active ();
+extern bool fastclock_supported ();
+extern void fastclock_recalibrate ();
+extern std::int64_t fastclock_ns ();
+extern std::int64_t fastclock_tsc_hz ();
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_FASTCLOCK_HPP
+
+/*
+ * fastclock.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,76 @@
+#if ! defined XPC66_XPC_FUTEX_HPP
+#define XPC66_XPC_FUTEX_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          futex.hpp
+ *
+ *  This module declares "wait on an address" helpers, the building block for
+ *  the light-weight semaphore, event, and barrier classes.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  futex_wait() sleeps only if the word still holds the expected value,
+ *  checked atomically with going to sleep, so a futex_wake() issued after
+ *  the word is changed cannot be lost.  All of the state lives in the word
+ *  itself; the kernel keeps a wait queue only while somebody sleeps.
+ *
+ *  On Linux these are the futex(2) system call, with the "private" flag,
+ *  since the words are never shared between processes.  Elsewhere, a small
+ *  table of mutexes and condition variables, selected by hashing the
+ *  address, stands in for the kernel's wait queues.
+ *
+ *  Neither call is made by the classes built on these in their uncontended
+ *  paths; those touch only the atomic word.
+ */
+
+#include <atomic>                       /* std::atomic<int>                 */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/*
+ *  Free functions in the futex module.
+ */
+
+extern bool futex_wait
+(
+    std::atomic<int> & word, int expected, long long timeout_ns = -1
+);
+extern void futex_wake (std::atomic<int> & word, int count = 1);
+extern void futex_wake_all (std::atomic<int> & word);
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_FUTEX_HPP
+
+/*
+ * futex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,96 @@
+#if ! defined XPC66_XPC_LOCKORDER_HPP
+#define XPC66_XPC_LOCKORDER_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          lockorder.hpp
+ *
+ *  This module declares a debug-build checker for the order in which
+ *  recmutexes are acquired, in the style of the Linux kernel's "lockdep".
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Deadlocks from inconsistent lock ordering usually need two threads to
+ *  interleave just so, which happens only under load.  The checker catches
+ *  the ordering mistake itself, even when no deadlock occurs:
+ *
+ *      -   Each thread keeps a list of the recmutexes it holds.
+ *      -   When a thread acquires mutex B while holding mutex A, the edge
+ *          A -> B is recorded in a process-wide graph, along with the stack
+ *          trace of the first time it was seen.
+ *      -   If B can already reach A in the graph, the new edge closes a
+ *          cycle.  That is a potential deadlock, and it is reported (once
+ *          per pair) with the names of the mutexes, the current stack, and
+ *          the stack recorded for the conflicting order.
+ *
+ *  The checking is done only when XPC66_LOCK_ORDER_CHECK is defined, which
+ *  is the case for PLATFORM_DEBUG builds of the library.  In a release
+ *  build, recmutex::lock() and unlock() contain no calls to this module, so
+ *  the cost is zero.  Give mutexes a name (see the recmutex constructor) to
+ *  make the reports readable.
+ */
+
+#include "platform_macros.h"            /* PLATFORM_DEBUG, PLATFORM_LINUX   */
+
+#if defined PLATFORM_DEBUG && ! defined XPC66_NO_LOCK_ORDER_CHECK
+#define XPC66_LOCK_ORDER_CHECK
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+class recmutex;
+
+#if defined XPC66_LOCK_ORDER_CHECK
+
+/*
+ *  Hooks called by recmutex.  They are not meant to be called otherwise.
+ */
+
+extern void lock_order_acquire (const recmutex * m);
+extern void lock_order_release (const recmutex * m);
+extern void lock_order_forget (const recmutex * m);
+
+/*
+ *  Inspection, for tests and for the curious.
+ */
+
+extern int lock_order_violations ();
+extern void lock_order_reset ();
+
+#endif
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_LOCKORDER_HPP
+
+/*
+ * lockorder.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
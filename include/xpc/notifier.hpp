@@ -0,0 +1,142 @@
+#if ! defined XPC66_XPC_NOTIFIER_HPP
+#define XPC66_XPC_NOTIFIER_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          notifier.hpp
+ *
+ *  This module declares a thread-to-thread wakeup that is a file
+ *  descriptor, so that it can be waited on with poll(), select(), or epoll
+ *  along with sockets and other descriptors.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  On Linux the descriptor is an eventfd(2); elsewhere it is the read end of
+ *  a non-blocking pipe.  Either way, it is readable once signal() has been
+ *  called, until drain() is called.  Usage in an I/O thread:
+ *
+\verbatim
+        xpc::notifier wakeup;                   // shared with the producers
+        ...
+        add wakeup.fd() to the epoll set, with EPOLLIN
+        ...
+        when it is readable:
+            wakeup.drain();                     // first drain, ...
+            process everything queued;          // ... then look for work
+\endverbatim
+ *
+ *  Repeated signals coalesce.  Only the first signal() after a drain()
+ *  makes a system call, so a busy producer that signals once per item is
+ *  cheap.  For this to be safe the consumer must drain() before it looks
+ *  for work, as above.
+ *
+ *  The notifier is POSIX-only.
+ */
+
+#include <atomic>                       /* std::atomic<bool>                */
+
+#include "xpc/waitable.hpp"             /* xpc::waitable base class         */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A pollable, coalescing wakeup.  Being a waitable, it can be passed to
+ *  wait_any().
+ */
+
+class notifier : public waitable
+{
+
+private:
+
+    /**
+     *  The descriptor to poll.  For eventfd, it is also the one written.
+     */
+
+    int m_read_fd;
+
+    /**
+     *  The descriptor written by signal().  The same as m_read_fd for
+     *  eventfd, the write end of the pipe otherwise.
+     */
+
+    int m_write_fd;
+
+    /**
+     *  True from the first signal() after a drain() until the next drain().
+     */
+
+    std::atomic<bool> m_pending;
+
+public:
+
+    notifier ();
+    notifier (const notifier &) = delete;
+    notifier & operator = (const notifier &) = delete;
+    virtual ~notifier ();
+
+    bool valid () const
+    {
+        return m_read_fd >= 0;
+    }
+
+    /**
+     *  The descriptor to wait on for readability.  The caller must not read
+     *  it or close it; use drain().
+     */
+
+    int fd () const
+    {
+        return m_read_fd;
+    }
+
+    virtual int wait_fd () const override
+    {
+        return m_read_fd;
+    }
+
+    bool pending () const
+    {
+        return m_pending.load();
+    }
+
+    void signal ();
+    bool drain ();
+
+};          // class notifier
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_NOTIFIER_HPP
+
+/*
+ * notifier.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,187 @@
+#if ! defined XPC66_XPC_PERIODICTIMER_HPP
+#define XPC66_XPC_PERIODICTIMER_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          periodictimer.hpp
+ *
+ *  This module declares a drift-free periodic timer for engine loops.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  A loop that calls microsleep(period) after each cycle runs slow by the
+ *  cycle's processing time plus the sleep's overshoot, every cycle, and
+ *  the error piles up.  The periodic_timer instead sleeps until absolute
+ *  deadlines, start + n * period, using clock_nanosleep() with
+ *  TIMER_ABSTIME on CLOCK_MONOTONIC.  Each wake-up can still be late, but
+ *  the lateness does not carry over to the next tick, so there is no
+ *  drift.
+ *
+\verbatim
+        xpc::periodic_timer timer(1000);        // 1 ms ticks
+        timer.start();
+        for (;;)
+        {
+            int missed = timer.wait();
+            if (missed > 0)
+                catch_up(missed);
+
+            process_one_cycle();
+        }
+\endverbatim
+ *
+ *  If a cycle runs past its deadline, wait() does not sleep, counts an
+ *  overrun, and skips any further deadlines that passed entirely, rather
+ *  than bursting through them.  The skipped ticks are reported so that
+ *  the caller can make up for them (e.g. by advancing the MIDI clock).
+ *
+ *  With set_precise(true), each wait sleeps only until a calibrated margin
+ *  before the deadline and spins the rest (see precise_sleep_until_ns()
+ *  in the timing module), for wake-ups within microseconds of the
+ *  deadline at the cost of that spin.
+ */
+
+#include <cstdint>                      /* std::int64_t                     */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  Wakes its thread at a fixed rate, without drift.  A timer is used by one
+ *  thread; it is not thread-safe.
+ */
+
+class periodic_timer
+{
+
+private:
+
+    /**
+     *  The period in nanoseconds.
+     */
+
+    std::int64_t m_period_ns;
+
+    /**
+     *  The next deadline, as a nanotime() value.  Zero until start() is
+     *  called.
+     */
+
+    std::int64_t m_next_ns;
+
+    /**
+     *  The number of deadlines reached (including late ones), but not
+     *  counting skipped ones.
+     */
+
+    std::int64_t m_ticks;
+
+    /**
+     *  The number of calls to wait() made after their deadline had passed.
+     */
+
+    std::int64_t m_overruns;
+
+    /**
+     *  The total number of deadlines skipped because they passed entirely.
+     */
+
+    std::int64_t m_missed;
+
+    /**
+     *  How late the most recent wake-up was, in nanoseconds.
+     */
+
+    std::int64_t m_lateness_ns;
+
+    /**
+     *  If true, the waits finish by spinning, for accuracy.
+     */
+
+    bool m_precise;
+
+public:
+
+    explicit periodic_timer (int period_us);
+
+    void start ();
+    int wait ();
+    void set_period (int period_us);
+    void resync ();
+
+    void set_precise (bool flag)
+    {
+        m_precise = flag;
+    }
+
+    bool precise () const
+    {
+        return m_precise;
+    }
+
+    int period_us () const
+    {
+        return int(m_period_ns / 1000);
+    }
+
+    std::int64_t ticks () const
+    {
+        return m_ticks;
+    }
+
+    std::int64_t overruns () const
+    {
+        return m_overruns;
+    }
+
+    std::int64_t missed_ticks () const
+    {
+        return m_missed;
+    }
+
+    std::int64_t lateness_ns () const
+    {
+        return m_lateness_ns;
+    }
+
+    std::int64_t next_deadline_ns () const
+    {
+        return m_next_ns;
+    }
+
+};          // class periodic_timer
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_PERIODICTIMER_HPP
+
+/*
+ * periodictimer.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
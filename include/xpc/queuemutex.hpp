@@ -0,0 +1,144 @@
+#if ! defined XPC66_XPC_QUEUEMUTEX_HPP
+#define XPC66_XPC_QUEUEMUTEX_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          queuemutex.hpp
+ *
+ *  This module declares a fair, first-come first-served queue lock (an "MCS"
+ *  lock) for heavily contended data on many-core machines.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  With a pthread mutex, every waiter polls or sleeps on the same lock word.
+ *  Each release then bounces that cache line to every waiting core, and
+ *  whichever core wins the race gets the lock, which is not necessarily the
+ *  one that has waited longest.
+ *
+ *  The MCS lock (Mellor-Crummey and Scott, 1991) instead forms the waiters
+ *  into a queue.  Each waiter spins on a flag in its own queue node, on its
+ *  own cache line.  The lock holder hands the lock directly to the next node
+ *  in the queue, touching only that waiter's cache line.  The result is
+ *  strict FIFO order and one cache-line transfer per hand-off, regardless of
+ *  the number of waiters.
+ *
+ *  The classic MCS interface passes a queue node to lock() and unlock().
+ *  Here each thread has a small pool of nodes, so queuemutex has the usual
+ *  lock()/unlock() interface and works with xpc::autolock<>:
+ *
+\verbatim
+        xpc::queuemutex m_hot_mutex;
+        xpc::autolock<xpc::queuemutex> guard{m_hot_mutex};
+\endverbatim
+ *
+ *  Caveats:
+ *
+ *      -   It is not recursive.
+ *      -   A thread may hold at most c_max_nested queuemutexes at once.
+ *      -   Waiters spin.  After c_spin_limit spins they also yield the
+ *          processor, so an oversubscribed machine does not livelock, but
+ *          the lock is best kept for short critical sections on threads
+ *          that have cores to themselves.  Since hand-off is FIFO, a waiter
+ *          that is preempted holds up everybody queued behind it.
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+
+#include "xpc/cpu_hints.hpp"            /* xpc::c_cache_line_size           */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A queue-based spin lock with FIFO hand-off.
+ */
+
+class queuemutex
+{
+
+public:
+
+    /**
+     *  The number of queuemutexes one thread can hold at the same time.
+     */
+
+    static const int c_max_nested = 16;
+
+    /**
+     *  The number of spins on the node flag before also yielding.
+     */
+
+    static const int c_spin_limit = 128;
+
+    /**
+     *  One waiter's place in the queue, alone on its cache line.
+     */
+
+    struct alignas(c_cache_line_size) qnode
+    {
+        std::atomic<qnode *> next;
+        std::atomic<bool> locked;
+    };
+
+private:
+
+    /**
+     *  The last node in the queue, or null if the lock is free.
+     */
+
+    std::atomic<qnode *> m_tail;
+
+    /**
+     *  The node of the current owner.  It is written only by the owner,
+     *  after it has the lock, and read only by the owner, in unlock().
+     */
+
+    qnode * m_owner_node;
+
+public:
+
+    queuemutex ();
+    queuemutex (const queuemutex &) = delete;
+    queuemutex & operator = (const queuemutex &) = delete;
+    ~queuemutex () = default;
+
+    void lock ();
+    void unlock ();
+    bool try_lock ();
+
+};          // class queuemutex
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_QUEUEMUTEX_HPP
+
+/*
+ * queuemutex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
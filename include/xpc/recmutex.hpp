@@ -27,7 +27,7 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2024-01-16
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  This recursive mutex is implemented in pthreads due to difficulties we had
@@ -101,13 +101,12 @@ public:
 
 private:
 
-    /**
-     *  Provides a recursive mutex that can be used by the whole
-     *  application, and is, apparently.
+    /*
+     *  There used to be a static "global" recursive mutex here.  It
+     *  serialized every object that used it; see the stripedmutex module
+     *  for the replacement, xpc::global_stripes().
      */
 
-    static native sm_global_mutex;
-
 #if defined PLATFORM_FREEBSD
 
     /**
@@ -120,15 +119,22 @@ private:
 
     /**
      *  Provides a mutex lock usable by a single module or class.
-     *  However, this mutex ends up being a copy of the static
-     *  sm_global_mutex (and, of course, a different "object").
      */
 
     mutable native m_mutex_lock;
 
+    /**
+     *  An optional name for the mutex, used in the reports of the
+     *  lock-order checker (see the lockorder module).  It must point to a
+     *  string that outlives the mutex, normally a literal.
+     */
+
+    const char * m_name;
+
 public:
 
     recmutex ();
+    explicit recmutex (const char * name);
     recmutex (recmutex &&) = delete;
     recmutex (const recmutex &);
     recmutex & operator = (recmutex &&) = delete;
@@ -147,11 +153,13 @@ public:
         return m_mutex_lock;
     }
 
+    const char * name () const
+    {
+        return m_name;
+    }
+
 private:
 
-#if defined USE_GLOBAL_MUTEX
-    static void init_global_mutex ();
-#endif
     void init ();
     void destroy ();
 
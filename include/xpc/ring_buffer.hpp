@@ -28,15 +28,20 @@
  * \library       xpc66 application
  * \author        Chris Ahlstrom
  * \date          2022-09-19
- * \updates       2022-11-23
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  */
 
+#include <cerrno>
+#include <chrono>
 #include <cstddef>
 #include <sys/types.h>
 #include <vector>
 
 #include "xpc_build_macros.h"           /* PLATFORM_DEBUG macro, etc.       */
+#include "xpc/notifier.hpp"             /* xpc::notifier for attach()       */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_token                  */
+#include "xpc/timing.hpp"               /* xpc::millisleep() with a token   */
 
 #undef  XPC66_USE_MEMORY_LOCK           /* TODO: needs a lot of work !      */
 
@@ -70,6 +75,7 @@ private:
     bool m_locked;              /**< Is memory locked? NOT YET SUPPORTED.   */
     size_type m_contents_max;   /**< Useful in trouble-shooting.            */
     int m_dropped;              /**< Number of items overwritten in run.    */
+    notifier * m_notifier;      /**< Optional "data available" wakeup.      */
 
 public:
 
@@ -78,6 +84,26 @@ public:
 
     bool mlock ();
 
+    /**
+     *  Attaches a notifier that push_back() (and hence write()) signals, so
+     *  that a consumer can wait for data in poll() or epoll along with its
+     *  other descriptors.  The consumer must call drain() on the notifier
+     *  before reading the buffer.  Pass nullptr to detach.  The notifier is
+     *  not owned, and must outlive the attachment.
+     */
+
+    void attach (notifier * n)
+    {
+        m_notifier = n;
+    }
+
+    notifier * attached () const
+    {
+        return m_notifier;
+    }
+
+    bool wait_for_data (const stop_token & token, int timeout_ms = -1);
+
     /**
      *  Reset the read and write pointers to zero. This is not thread safe.
      *  Neither is the clear() function.
@@ -195,7 +221,8 @@ ring_buffer<TYPE>::ring_buffer (size_type sz) :
     m_size_mask     (0),
     m_locked        (false),
     m_contents_max  (0),
-    m_dropped       (0)
+    m_dropped       (0),
+    m_notifier      (nullptr)
 {
     int power_of_two;
     for (power_of_two = 1; 1 << power_of_two < int(sz); ++power_of_two)
@@ -228,7 +255,7 @@ template<typename TYPE>
 void
 ring_buffer<TYPE>::initialize ()
 {
-    TYPE empty_value;
+    TYPE empty_value {};                /* value-initialized, even scalars  */
     m_buffer.clear();
     m_buffer.reserve(m_buffer_size);
     for (size_t i = 0; i < m_buffer_size; ++i)
@@ -387,7 +414,8 @@ ring_buffer<TYPE>::read (reference dest)
 
 /**
  *  Increment the tail, then increment the head. This function supports the
- *  special case of an empty buffer.
+ *  special case of an empty buffer.  If a notifier is attached, it is
+ *  signalled after the item is stored.
  */
 
 template<typename TYPE>
@@ -412,9 +440,83 @@ ring_buffer<TYPE>::push_back (const value_type & item)
         increment_tail();
         ++m_dropped;                        /* for future use in expansion  */
     }
+    if (m_notifier != nullptr)
+        m_notifier->signal();
+
     return true;
 }
 
+/**
+ *  Waits until the buffer is not empty, a stop is requested, or the time
+ *  runs out.  With an attached notifier, this blocks in wait_any() on the
+ *  notifier and the token, and drains the notifier itself, so the consumer
+ *  should not; new data or a stop wakes it at once.  Without a notifier,
+ *  or where wait_any() cannot poll, it naps a millisecond at a time: a
+ *  stop still wakes it at once, but new data is seen up to 1 ms late.
+ *  Attach a notifier where that latency matters.
+ *
+ * \param token
+ *      The stop token to watch.
+ *
+ * \param timeout_ms
+ *      The longest wait, in milliseconds.  Negative means no limit.
+ *
+ * \return
+ *      Returns true if there is data to read.
+ */
+
+template<typename TYPE>
+bool
+ring_buffer<TYPE>::wait_for_data (const stop_token & token, int timeout_ms)
+{
+    using clock = std::chrono::steady_clock;
+    clock::time_point deadline = clock::now() +
+        std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+
+    const waitable * stop = token.get_waitable();
+    for (;;)
+    {
+        if (m_notifier != nullptr)
+            (void) m_notifier->drain();
+
+        if (! empty())
+            return true;
+
+        if (token.stop_requested())
+            return false;
+
+        int remaining = -1;
+        if (timeout_ms >= 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>
+            (
+                deadline - clock::now()
+            ).count();
+            if (left <= 0)
+                return false;
+
+            remaining = int(left);
+        }
+
+        /*
+         * Without descriptors to poll (no notifier, no eventfd, or a
+         * platform without poll()), or on a descriptor error, wait_any()
+         * returns -1 at once, so nap instead of spinning.
+         */
+
+        bool pollable = m_notifier != nullptr && m_notifier->wait_fd() >= 0 &&
+            (stop == nullptr || stop->wait_fd() >= 0);
+
+        if (! pollable)
+            (void) millisleep(1, token);
+        else if (wait_any({ m_notifier, stop }, remaining) < 0)
+        {
+            if (errno != ETIMEDOUT)
+                (void) millisleep(1, token);
+        }
+    }
+}
+
 /*
  *  Free functions (for testing the ring_buffer).
  */
@@ -0,0 +1,264 @@
+#if ! defined XPC66_XPC_RWMUTEX_HPP
+#define XPC66_XPC_RWMUTEX_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          rwmutex.hpp
+ *
+ *  This module declares/defines a reader-writer lock and its automatic
+ *  (exception-safe) guards.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Configuration and song data is read by many threads and written rarely.
+ *  A recmutex serializes all of those readers.  The rwmutex lets any number
+ *  of readers in at once, and makes a writer wait only for the readers
+ *  already inside.
+ *
+ *  Like recmutex, this class wraps a pthreads object, here the
+ *  pthread_rwlock_t.  Unlike recmutex, it is not recursive.  In particular,
+ *  with the writer-preferring policy, a thread that already holds a read
+ *  lock must not ask for it again, since a waiting writer blocks the second
+ *  request and the thread deadlocks itself.
+ *
+ *  This module defines the following classes:
+ *
+ *      -   xpc::rwmutex.  The reader-writer lock.
+ *      -   xpc::autoreadlock.  Like automutex, but takes a shared (read)
+ *          lock.
+ *      -   xpc::autowritelock.  Like automutex, but takes the exclusive
+ *          (write) lock.
+ */
+
+#include "platform_macros.h"            /* pick the compiler and platform   */
+
+#include <pthread.h>
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  The rwmutex class provides a simple wrapper for the pthread_rwlock_t
+ *  type.  It meets the C++ SharedLockable requirements, so it can also be
+ *  used with std::shared_lock<> and std::unique_lock<>.
+ */
+
+class rwmutex
+{
+
+public:
+
+    /**
+     *  The native type of reader-writer lock in use.
+     */
+
+    using native = pthread_rwlock_t;
+
+    /**
+     *  Selects who gets the lock first when readers and writers are both
+     *  waiting.
+     *
+     *      -   reader_preferred. New readers can enter while a writer waits.
+     *          Best throughput for readers, but a steady stream of readers
+     *          can starve a writer (e.g. a "save" operation) forever.
+     *      -   writer_preferred. Once a writer waits, new readers are held
+     *          off until it is done.  This is the default.
+     */
+
+    enum class policy
+    {
+        reader_preferred,
+        writer_preferred
+    };
+
+private:
+
+    /**
+     *  The policy requested at construction.  Some platforms do not
+     *  support the writer-preferring policy; in that case the lock falls
+     *  back to the platform default, but we remember what was asked for.
+     */
+
+    policy m_policy;
+
+    /**
+     *  The reader-writer lock itself.
+     */
+
+    mutable native m_rw_lock;
+
+public:
+
+    rwmutex (policy p = policy::writer_preferred);
+    rwmutex (rwmutex &&) = delete;
+    rwmutex (const rwmutex &);
+    rwmutex & operator = (rwmutex &&) = delete;
+    rwmutex & operator = (const rwmutex &);
+    ~rwmutex ();
+
+    void lock () const;
+    void unlock () const;
+    bool try_lock () const;
+    void lock_shared () const;
+    void unlock_shared () const;
+    bool try_lock_shared () const;
+
+    policy lock_policy () const
+    {
+        return m_policy;
+    }
+
+    native & native_locker () const
+    {
+        return m_rw_lock;
+    }
+
+private:
+
+    void init ();
+    void destroy ();
+
+};          // class rwmutex
+
+/**
+ *  Provides a shared (read) lock that locks automatically when created, and
+ *  unlocks when destroyed.  It is the read-side counterpart of automutex.
+ */
+
+class autoreadlock
+{
+
+private:
+
+    /**
+     *  Provides the reader-writer lock reference to be used for locking.
+     */
+
+    const rwmutex & m_safety_mutex;
+
+private:                        /* do not allow these functions to be used  */
+
+    autoreadlock () = delete;
+    autoreadlock (const autoreadlock &) = delete;
+    autoreadlock & operator = (const autoreadlock &) = delete;
+
+public:
+
+    /**
+     *  Principal constructor gets a reference to a rwmutex parameter, and
+     *  then takes a shared lock on it.
+     *
+     * \param my_mutex
+     *      The caller's reader-writer lock.
+     */
+
+    autoreadlock (const rwmutex & my_mutex) : m_safety_mutex (my_mutex)
+    {
+        lock();
+    }
+
+    ~autoreadlock ()
+    {
+        unlock();
+    }
+
+    void lock ()
+    {
+        m_safety_mutex.lock_shared();
+    }
+
+    void unlock ()
+    {
+        m_safety_mutex.unlock_shared();
+    }
+
+};          // class autoreadlock
+
+/**
+ *  Provides an exclusive (write) lock that locks automatically when created,
+ *  and unlocks when destroyed.
+ */
+
+class autowritelock
+{
+
+private:
+
+    /**
+     *  Provides the reader-writer lock reference to be used for locking.
+     */
+
+    const rwmutex & m_safety_mutex;
+
+private:                        /* do not allow these functions to be used  */
+
+    autowritelock () = delete;
+    autowritelock (const autowritelock &) = delete;
+    autowritelock & operator = (const autowritelock &) = delete;
+
+public:
+
+    /**
+     *  Principal constructor gets a reference to a rwmutex parameter, and
+     *  then takes the exclusive lock on it.
+     *
+     * \param my_mutex
+     *      The caller's reader-writer lock.
+     */
+
+    autowritelock (const rwmutex & my_mutex) : m_safety_mutex (my_mutex)
+    {
+        lock();
+    }
+
+    ~autowritelock ()
+    {
+        unlock();
+    }
+
+    void lock ()
+    {
+        m_safety_mutex.lock();
+    }
+
+    void unlock ()
+    {
+        m_safety_mutex.unlock();
+    }
+
+};          // class autowritelock
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_RWMUTEX_HPP
+
+/*
+ * rwmutex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,137 @@
+#if ! defined XPC66_XPC_SEMAPHORE_HPP
+#define XPC66_XPC_SEMAPHORE_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          semaphore.hpp
+ *
+ *  This module declares a light-weight counting semaphore and an auto-reset
+ *  event, built on the futex helpers.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  xpc::condition (a recursive mutex plus a pthread condition variable) and
+ *  xpc::synchronizer (a mutex, a condition variable, and a virtual
+ *  predicate) are heavy for simple signalling such as "N items are
+ *  available" or "go".  These classes keep all of their state in two atomic
+ *  words:
+ *
+ *      -   The value (the count, or the event's set/clear state).
+ *      -   The number of threads that are, or are about to be, asleep.
+ *
+ *  Posting or setting with no sleeper is one atomic read-modify-write plus
+ *  one load; taking an available count or a set event is one
+ *  compare-exchange.  Neither makes a system call.  A waiter that finds
+ *  nothing spins briefly before it sleeps in futex_wait(), since the other
+ *  thread is often only a few hundred nanoseconds away from posting.
+ */
+
+#include <atomic>                       /* std::atomic<int>                 */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A counting semaphore.  post() adds to the count and wait() takes one from
+ *  it, sleeping while it is zero.
+ */
+
+class semaphore
+{
+
+private:
+
+    std::atomic<int> m_count;
+    std::atomic<int> m_waiters;
+
+public:
+
+    explicit semaphore (int initial = 0);
+    semaphore (const semaphore &) = delete;
+    semaphore & operator = (const semaphore &) = delete;
+    ~semaphore () = default;
+
+    void post (int n = 1);
+    void wait ();
+    bool try_wait ();
+    bool wait_for (int us);
+
+    int count () const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+};          // class semaphore
+
+/**
+ *  An auto-reset event.  signal() sets it, and one wait() consumes it,
+ *  clearing it again.  Signals made while it is already set do not
+ *  accumulate; use a semaphore for that.
+ */
+
+class autoevent
+{
+
+private:
+
+    std::atomic<int> m_state;
+    std::atomic<int> m_waiters;
+
+public:
+
+    explicit autoevent (bool initially_set = false);
+    autoevent (const autoevent &) = delete;
+    autoevent & operator = (const autoevent &) = delete;
+    ~autoevent () = default;
+
+    void signal ();
+    void wait ();
+    bool try_wait ();
+    bool wait_for (int us);
+
+    void reset ()
+    {
+        m_state.store(0);
+    }
+
+    bool is_set () const
+    {
+        return m_state.load(std::memory_order_relaxed) != 0;
+    }
+
+};          // class autoevent
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_SEMAPHORE_HPP
+
+/*
+ * semaphore.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
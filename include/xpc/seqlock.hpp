@@ -0,0 +1,246 @@
+#if ! defined XPC66_XPC_SEQLOCK_HPP
+#define XPC66_XPC_SEQLOCK_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          seqlock.hpp
+ *
+ *  This module defines a sequence lock for small, trivially-copyable data
+ *  that has a single writer and many readers.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Transport position, tempo, and the beat counter are written by the
+ *  real-time thread and polled by the GUI and network threads.  Taking a
+ *  recmutex for every one of those reads costs the writer, too, since it
+ *  must contend for the same lock.  With a seqlock:
+ *
+ *      -   The writer never blocks.  It bumps a sequence number to an odd
+ *          value, stores the data, then bumps it to the next even value.
+ *      -   A reader notes the sequence number, copies the data, then checks
+ *          the number again.  If it was odd, or it changed, the copy may be
+ *          torn, and the reader tries again.
+ *
+ *  There must be only one writer at a time.  If there can be more than
+ *  one, they must serialize among themselves (for example, with a
+ *  recmutex); the readers still take no lock.
+ *
+ *  To stay within the C++ memory model, the data is kept in an array of
+ *  atomic words that are read and written with relaxed ordering, and the
+ *  fences follow H. Boehm, "Can Seqlocks Get Along with Programming
+ *  Language Memory Models?" (2012).  On the usual platforms a relaxed
+ *  atomic access of a word is a plain load or store.
+ *
+ *  Example:
+ *
+\verbatim
+        struct position { long tick; double bpm; int beat; };
+        xpc::seqlock<position> s_position;
+
+        s_position.store(p);                    // RT thread
+        position p = s_position.load();         // GUI thread
+\endverbatim
+ */
+
+#include <atomic>                       /* std::atomic<>, fences            */
+#include <cstdint>                      /* std::uintptr_t                   */
+#include <cstring>                      /* std::memcpy()                    */
+#include <thread>                       /* std::this_thread::yield()        */
+#include <type_traits>                  /* std::is_trivially_copyable<>     */
+
+#include "xpc/cpu_hints.hpp"            /* xpc::cpu_relax()                 */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A single-writer, multiple-reader sequence lock holding one TYPE value.
+ */
+
+template <typename TYPE>
+class seqlock
+{
+    static_assert
+    (
+        std::is_trivially_copyable<TYPE>::value,
+        "seqlock requires a trivially copyable type"
+    );
+
+public:
+
+    using value_type = TYPE;
+
+    /**
+     *  Number of reader spins before the reader also yields the processor.
+     *  A retry normally succeeds at once; a long wait means the writer was
+     *  preempted in the middle of a store.
+     */
+
+    static const int c_spin_limit = 64;
+
+private:
+
+    using word = std::uintptr_t;
+
+    /**
+     *  The number of machine words needed to hold a TYPE.
+     */
+
+    static const std::size_t c_word_count =
+        (sizeof(TYPE) + sizeof(word) - 1) / sizeof(word);
+
+    /**
+     *  The sequence number.  It is odd while a store is in progress.
+     */
+
+    std::atomic<unsigned> m_sequence;
+
+    /**
+     *  The value, spread over atomic words.
+     */
+
+    std::atomic<word> m_data[c_word_count];
+
+public:
+
+    seqlock () : m_sequence (0)
+    {
+        for (auto & w : m_data)
+            w.store(0, std::memory_order_relaxed);
+    }
+
+    explicit seqlock (const value_type & value) : m_sequence (0)
+    {
+        store(value);
+    }
+
+    seqlock (const seqlock &) = delete;
+    seqlock & operator = (const seqlock &) = delete;
+
+    void store (const value_type & value);
+    bool try_load (value_type & destination) const;
+
+    /**
+     *  Reads a consistent copy of the value, retrying as needed.  It never
+     *  blocks the writer.
+     */
+
+    value_type load () const
+    {
+        value_type result;
+        int spins = 0;
+        while (! try_load(result))
+        {
+            if (++spins < c_spin_limit)
+            {
+                cpu_relax();
+            }
+            else
+            {
+                spins = 0;
+                std::this_thread::yield();
+            }
+        }
+        return result;
+    }
+
+    /**
+     *  The current sequence number.  It advances by two for each store, so
+     *  a reader can also use it to see if the value changed since it was
+     *  last read.
+     */
+
+    unsigned sequence () const
+    {
+        return m_sequence.load(std::memory_order_acquire);
+    }
+
+};          // class seqlock<TYPE>
+
+/**
+ *  Stores a new value.  Only one thread at a time may call this function.
+ *  It makes no system calls and never waits.
+ */
+
+template <typename TYPE>
+void
+seqlock<TYPE>::store (const value_type & value)
+{
+    word buffer[c_word_count] = {};
+    std::memcpy(buffer, &value, sizeof(TYPE));
+
+    unsigned s = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(s + 1, std::memory_order_relaxed);     /* odd: busy    */
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < c_word_count; ++i)
+        m_data[i].store(buffer[i], std::memory_order_relaxed);
+
+    m_sequence.store(s + 2, std::memory_order_release);     /* even: done   */
+}
+
+/**
+ *  Makes one attempt at reading the value.
+ *
+ * \param [out] destination
+ *      Receives the value, but only if the read was consistent.
+ *
+ * \return
+ *      Returns true if the value was copied, and false if a store was in
+ *      progress or happened during the copy.
+ */
+
+template <typename TYPE>
+bool
+seqlock<TYPE>::try_load (value_type & destination) const
+{
+    unsigned s1 = m_sequence.load(std::memory_order_acquire);
+    if ((s1 & 1) != 0)
+        return false;
+
+    word buffer[c_word_count];
+    for (std::size_t i = 0; i < c_word_count; ++i)
+        buffer[i] = m_data[i].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    unsigned s2 = m_sequence.load(std::memory_order_relaxed);
+    if (s1 != s2)
+        return false;
+
+    std::memcpy(&destination, buffer, sizeof(TYPE));
+    return true;
+}
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_SEQLOCK_HPP
+
+/*
+ * seqlock.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,268 @@
+#if ! defined XPC66_XPC_STOPTOKEN_HPP
+#define XPC66_XPC_STOPTOKEN_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          stoptoken.hpp
+ *
+ *  This module declares cooperative cancellation, in the manner of the
+ *  C++20 std::stop_source, std::stop_token, and std::stop_callback.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  A stop_source requests the stop; any number of stop_tokens, copied from
+ *  it and handed to threads, observe it.  Unlike a plain atomic flag, a
+ *  token also cuts short the waits that accept one:
+ *
+ *      -   xpc::microsleep(us, token) and xpc::millisleep(ms, token).
+ *      -   condition::wait(token) and synchronizer::wait(token).
+ *      -   ring_buffer::wait_for_data(token, ms).
+ *      -   wait_any(), via stop_token::get_waitable().
+ *
+ *  So shutdown takes as long as the threads need to notice, microseconds,
+ *  rather than the sum of their sleep periods:
+ *
+\verbatim
+        xpc::stop_source stopper;
+        std::thread worker
+        (
+            [token = stopper.get_token()] ()
+            {
+                while (xpc::millisleep(100, token))
+                    do_periodic_work();
+            }
+        );
+        ...
+        stopper.request_stop();                 // worker wakes at once
+        worker.join();
+\endverbatim
+ *
+ *  A stop_callback runs a function when the stop is requested (or at once,
+ *  if it already was).  Callbacks run in the thread that calls
+ *  request_stop(), one at a time, without any lock of the stop state held,
+ *  so they may take the caller's own locks.
+ *
+ *  request_stop() is not async-signal-safe, because of the callbacks.  A
+ *  signal handler calls request_stop_async() instead, which only sets the
+ *  stop (waking the sleeps and the waitable); some ordinary thread then
+ *  calls run_callbacks().  That is safe only in Linux, where the wakeup is
+ *  a futex system call; elsewhere futex_wake_all() takes a std::mutex.
+ */
+
+#include <atomic>                       /* std::atomic<int>                 */
+#include <condition_variable>           /* std::condition_variable          */
+#include <functional>                   /* std::function<>                  */
+#include <map>                          /* std::map<>                       */
+#include <memory>                       /* std::shared_ptr<>                */
+#include <mutex>                        /* std::mutex                       */
+#include <thread>                       /* std::thread::id                  */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+class notifier;
+class waitable;
+
+/**
+ *  The state shared by a stop_source and its tokens.  Not for direct use.
+ */
+
+class stop_state
+{
+
+    friend class stop_source;
+    friend class stop_token;
+    friend class stop_callback;
+
+private:
+
+    /**
+     *  0 until a stop is requested, then 1.  It is also a futex word, so
+     *  that sleeps can wait on it.
+     */
+
+    std::atomic<int> m_stopped;
+
+    /**
+     *  Guards the callbacks and the notifier.  It is never held while a
+     *  callback runs.
+     */
+
+    std::mutex m_mutex;
+
+    /**
+     *  Registered callbacks, by registration number.  Each is removed just
+     *  before it runs.
+     */
+
+    std::map<unsigned long, std::function<void ()>> m_callbacks;
+
+    unsigned long m_next_id;
+
+    /**
+     *  The callback being run, or 0, and the thread running it.  A
+     *  stop_callback destructor in another thread waits on m_done until
+     *  its callback is no longer the one running.
+     */
+
+    unsigned long m_running_id;
+    std::thread::id m_running_thread;
+    std::condition_variable m_done;
+
+    /**
+     *  True while some thread is in run_callbacks().
+     */
+
+    bool m_dispatching;
+
+    /**
+     *  Created only when somebody asks for a waitable.  The atomic copy of
+     *  the pointer is for request_stop_async(), which cannot lock.
+     */
+
+    std::unique_ptr<notifier> m_notifier;
+    std::atomic<notifier *> m_notifier_ptr;
+
+public:
+
+    stop_state ();
+    ~stop_state ();
+
+};          // class stop_state
+
+/**
+ *  Observes a stop_source.  Cheap to copy.  A default-constructed token has
+ *  no source, and can never be stopped.
+ */
+
+class stop_token
+{
+
+    friend class stop_source;
+    friend class stop_callback;
+
+private:
+
+    std::shared_ptr<stop_state> m_state;
+
+    explicit stop_token (const std::shared_ptr<stop_state> & s) :
+        m_state (s)
+    {
+        // no code
+    }
+
+public:
+
+    stop_token () = default;
+
+    bool stop_requested () const
+    {
+        return m_state && m_state->m_stopped.load() != 0;
+    }
+
+    bool stop_possible () const
+    {
+        return bool(m_state);
+    }
+
+    /**
+     *  The futex word for waits, or null for a token with no source.
+     */
+
+    std::atomic<int> * stop_word () const
+    {
+        return m_state ? &m_state->m_stopped : nullptr ;
+    }
+
+    const waitable * get_waitable () const;
+
+};          // class stop_token
+
+/**
+ *  Requests a stop, once, for all of its tokens.
+ */
+
+class stop_source
+{
+
+private:
+
+    std::shared_ptr<stop_state> m_state;
+
+public:
+
+    stop_source ();
+
+    stop_token get_token () const
+    {
+        return stop_token(m_state);
+    }
+
+    bool stop_requested () const
+    {
+        return m_state->m_stopped.load() != 0;
+    }
+
+    bool request_stop ();
+    bool request_stop_async ();
+    void run_callbacks ();
+
+};          // class stop_source
+
+/**
+ *  Runs a function when a stop is requested.  It is unregistered by the
+ *  destructor, which waits only if the function is running right then in
+ *  another thread, as std::stop_callback does.
+ */
+
+class stop_callback
+{
+
+private:
+
+    std::shared_ptr<stop_state> m_state;
+    unsigned long m_id;
+
+public:
+
+    stop_callback (const stop_token & token, std::function<void ()> f);
+    stop_callback (const stop_callback &) = delete;
+    stop_callback & operator = (const stop_callback &) = delete;
+    ~stop_callback ();
+
+};          // class stop_callback
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_STOPTOKEN_HPP
+
+/*
+ * stoptoken.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,293 @@
+#if ! defined XPC66_XPC_STRIPEDMUTEX_HPP
+#define XPC66_XPC_STRIPEDMUTEX_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          stripedmutex.hpp
+ *
+ *  This module declares/defines a striped lock table, a fixed set of
+ *  recursive mutexes selected by hashing an object address or a key.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  A single process-wide mutex serializes every object that uses it, even
+ *  objects that have nothing to do with each other.  Giving every object its
+ *  own mutex is not always possible (the object may be a plain struct, or
+ *  not owned by us).  A striped table is in between: N mutexes, each on its
+ *  own cache line, with an object mapped to one of them by a hash of its
+ *  address.  Two unrelated objects collide only 1 time in N, so contention
+ *  grows with the number of distinct objects being locked, not with total
+ *  activity.
+ *
+ *  Each stripe is a recmutex.  Since stripes are shared, a thread can lock
+ *  object A and then object B that happens to hash to the same stripe; the
+ *  recursive mutex makes that harmless.
+ *
+ *  This module defines the following classes:
+ *
+ *      -   xpc::stripedmutex<N>.  The table of N stripes.  N must be a
+ *          power of two.
+ *      -   xpc::autostripe.  A guard like automutex that locks one stripe,
+ *          or two stripes in a consistent (address) order so that two
+ *          threads locking the same pair cannot deadlock.
+ *
+ *  The stripes are cache-line aligned.  Under C++14, operator new ignores
+ *  that alignment, so a table should be a static object or a member of
+ *  one, rather than allocated by itself with new.  The global_stripes()
+ *  function provides a process-wide table.
+ */
+
+#include <array>                        /* std::array<>                     */
+#include <cstdint>                      /* std::uintptr_t, std::uint64_t    */
+#include <functional>                   /* std::hash<>, std::less<>         */
+
+#include "xpc/cpu_hints.hpp"            /* xpc::c_cache_line_size           */
+#include "xpc/recmutex.hpp"             /* xpc::recmutex wrapper class      */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  The default number of stripes.  Comfortably more than the number of
+ *  threads we run, so that unrelated objects rarely collide.
+ */
+
+const std::size_t c_default_stripes = 64;
+
+/**
+ *  Mixes the bits of a pointer or key so that nearby addresses (which differ
+ *  mostly in the low bits) spread evenly over the stripes.  This is
+ *  Fibonacci hashing: multiply by 2^64 / phi and keep the top bits.
+ */
+
+inline std::size_t
+stripe_hash (std::uint64_t key, unsigned bits)
+{
+    return bits == 0 ? 0 :
+        std::size_t((key * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+/**
+ *  A table of STRIPES recursive mutexes, each padded to its own cache line.
+ */
+
+template <std::size_t STRIPES = c_default_stripes>
+class stripedmutex
+{
+    static_assert
+    (
+        STRIPES > 0 && (STRIPES & (STRIPES - 1)) == 0,
+        "stripedmutex requires a power-of-two stripe count"
+    );
+
+private:
+
+    /**
+     *  One mutex, alone on its cache line.
+     */
+
+    struct alignas(c_cache_line_size) stripe
+    {
+        recmutex m_mutex;
+    };
+
+    /**
+     *  The table itself.
+     */
+
+    std::array<stripe, STRIPES> m_stripes;
+
+    /**
+     *  Computes log2(STRIPES) at compile time.
+     */
+
+    static constexpr unsigned bit_count (std::size_t n)
+    {
+        return n <= 1 ? 0 : 1 + bit_count(n / 2);
+    }
+
+public:
+
+    stripedmutex () = default;
+    stripedmutex (const stripedmutex &) = delete;
+    stripedmutex & operator = (const stripedmutex &) = delete;
+
+    static constexpr std::size_t size ()
+    {
+        return STRIPES;
+    }
+
+    /**
+     *  Index of the stripe for an object.  The low bits of an address are
+     *  mostly alignment zeroes, so they are shifted out before hashing.
+     */
+
+    std::size_t index (const void * object) const
+    {
+        std::uintptr_t p = reinterpret_cast<std::uintptr_t>(object);
+        return stripe_hash(std::uint64_t(p >> 4), bit_count(STRIPES));
+    }
+
+    /**
+     *  Index of the stripe for an arbitrary key, such as a sequence number
+     *  or a name.
+     */
+
+    template <typename KEY>
+    std::size_t index_of_key (const KEY & key) const
+    {
+        return stripe_hash
+        (
+            std::uint64_t(std::hash<KEY>{}(key)), bit_count(STRIPES)
+        );
+    }
+
+    recmutex & stripe_at (std::size_t i)
+    {
+        return m_stripes[i & (STRIPES - 1)].m_mutex;
+    }
+
+    recmutex & stripe_for (const void * object)
+    {
+        return stripe_at(index(object));
+    }
+
+    template <typename KEY>
+    recmutex & stripe_for_key (const KEY & key)
+    {
+        return stripe_at(index_of_key(key));
+    }
+
+};          // class stripedmutex<STRIPES>
+
+/**
+ *  The process-wide stripe table.  Use it instead of one "global" mutex:
+ *
+\verbatim
+        xpc::autostripe guard{xpc::global_stripes(), this};
+\endverbatim
+ */
+
+using global_stripe_table = stripedmutex<c_default_stripes>;
+
+extern global_stripe_table & global_stripes ();
+
+/**
+ *  Locks one or two stripes automatically when created, and unlocks them
+ *  when destroyed.  When given two mutexes, it always locks the one at the
+ *  lower address first, so two threads locking the same pair in opposite
+ *  argument order still cannot deadlock.  If both objects map to the same
+ *  stripe, it is locked only once.
+ *
+ *  It works with any pair of recmutexes, not just stripes from one table.
+ */
+
+class autostripe
+{
+
+private:
+
+    /**
+     *  The first mutex locked, and the second one (or null).
+     */
+
+    recmutex * m_first;
+    recmutex * m_second;
+
+private:                        /* do not allow these functions to be used  */
+
+    autostripe () = delete;
+    autostripe (const autostripe &) = delete;
+    autostripe & operator = (const autostripe &) = delete;
+
+public:
+
+    explicit autostripe (recmutex & m) :
+        m_first     (&m),
+        m_second    (nullptr)
+    {
+        lock();
+    }
+
+    autostripe (recmutex & m1, recmutex & m2) :
+        m_first     (std::less<recmutex *>{}(&m1, &m2) ? &m1 : &m2),
+        m_second    (&m1 == &m2 ? nullptr : (m_first == &m1 ? &m2 : &m1))
+    {
+        lock();
+    }
+
+    template <std::size_t STRIPES>
+    autostripe (stripedmutex<STRIPES> & table, const void * object) :
+        autostripe  (table.stripe_for(object))
+    {
+        // no code
+    }
+
+    template <std::size_t STRIPES>
+    autostripe
+    (
+        stripedmutex<STRIPES> & table,
+        const void * object1,
+        const void * object2
+    ) :
+        autostripe  (table.stripe_for(object1), table.stripe_for(object2))
+    {
+        // no code
+    }
+
+    ~autostripe ()
+    {
+        unlock();
+    }
+
+    void lock ()
+    {
+        m_first->lock();
+        if (m_second != nullptr)
+            m_second->lock();
+    }
+
+    void unlock ()
+    {
+        if (m_second != nullptr)
+            m_second->unlock();
+
+        m_first->unlock();
+    }
+
+};          // class autostripe
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_STRIPEDMUTEX_HPP
+
+/*
+ * stripedmutex.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,230 @@
+#if ! defined XPC66_XPC_THREADATTRIBUTES_HPP
+#define XPC66_XPC_THREADATTRIBUTES_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          threadattributes.hpp
+ *
+ *  This module declares a builder for the real-time settings of a thread:
+ *  scheduling policy, CPU affinity, name, and a prefaulted stack.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  set_thread_priority() supports only SCHED_FIFO, and it can only be
+ *  applied to a std::thread that is already running, so a real-time
+ *  thread starts out at normal priority, unpinned, and takes its first
+ *  stack page faults inside its time-critical loop.  A thread_attributes
+ *  object collects the settings, and launch() starts a std::thread that
+ *  applies them to itself before it runs the body:
+ *
+\verbatim
+        std::thread t;
+        xpc::thread_status s = xpc::thread_attributes()
+            .fifo(80)
+            .affinity({ 2 })
+            .name("midi-out")
+            .prefault_stack(256 * 1024)
+            .launch(t, [&] { output_loop(); });
+        if (! s.ok())
+            xpc::error_message("midi-out", s.message);  // body not run
+\endverbatim
+ *
+ *  The settings are applied in this order: name, affinity, prefaulted
+ *  stack (still at normal priority, since page faults are slow), and
+ *  last the policy.  launch() waits until they are applied and returns
+ *  the outcome.  If one fails, the body is not run (unless best_effort()
+ *  was set), and the thread is joined, so \a t is left empty.  apply()
+ *  applies the settings to the calling thread.
+ *
+ *  deadline() cannot be combined with affinity(): the kernel refuses
+ *  SCHED_DEADLINE for a thread with a narrowed affinity, so that
+ *  combination fails at once with EINVAL (step::policy), before anything
+ *  is applied.
+ *
+ *  The settings are Linux features.  With other POSIX threads only the
+ *  FIFO, RR, and OTHER policies (without nice) and the stack prefault
+ *  are done; the rest fail with ENOTSUP.
+ */
+
+#include <cstddef>                      /* std::size_t                      */
+#include <cstdint>                      /* std::int64_t                     */
+#include <functional>                   /* std::function<>                  */
+#include <initializer_list>             /* std::initializer_list<>          */
+#include <string>                       /* std::string                      */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  The outcome of applying a thread_attributes.
+ */
+
+struct thread_status
+{
+    /**
+     *  The setting that failed, if any.
+     */
+
+    enum class step
+    {
+        none,
+        name,
+        affinity,
+        stack,
+        policy,
+        launch
+    };
+
+    step failed = step::none;
+
+    /**
+     *  The errno value of the failure, e.g. EPERM for a real-time policy
+     *  without the privilege for it.
+     */
+
+    int error = 0;
+
+    /**
+     *  A readable description of the failure, empty on success.
+     */
+
+    std::string message;
+
+    bool ok () const
+    {
+        return failed == step::none;
+    }
+
+};          // struct thread_status
+
+/**
+ *  A builder of thread settings.  Each setter returns *this.
+ */
+
+class thread_attributes
+{
+
+public:
+
+    enum class policy
+    {
+        inherit,                        /* leave the policy alone           */
+        other,                          /* SCHED_OTHER, with a nice value   */
+        fifo,                           /* SCHED_FIFO                       */
+        round_robin,                    /* SCHED_RR                         */
+        deadline                        /* SCHED_DEADLINE                   */
+    };
+
+private:
+
+    policy m_policy;
+
+    /**
+     *  The real-time priority for FIFO and RR, or the nice value for
+     *  OTHER.
+     */
+
+    int m_priority;
+
+    /**
+     *  The SCHED_DEADLINE parameters, in nanoseconds.  A period of 0 means
+     *  the deadline.
+     */
+
+    std::int64_t m_runtime_ns;
+    std::int64_t m_deadline_ns;
+    std::int64_t m_period_ns;
+
+    /**
+     *  The CPUs to run on; empty to leave the affinity alone.
+     */
+
+    std::vector<int> m_cpus;
+
+    /**
+     *  The thread name; empty to leave it alone.  Linux allows 15
+     *  characters, and longer names are cut.
+     */
+
+    std::string m_name;
+
+    /**
+     *  The number of stack bytes to touch, or 0.
+     */
+
+    std::size_t m_prefault_bytes;
+
+    /**
+     *  If true, launch() runs the body even if a setting fails.
+     */
+
+    bool m_best_effort;
+
+public:
+
+    thread_attributes ();
+
+    thread_attributes & fifo (int priority);
+    thread_attributes & round_robin (int priority);
+    thread_attributes & other (int nice = 0);
+    thread_attributes & deadline
+    (
+        std::int64_t runtime_ns,
+        std::int64_t deadline_ns,
+        std::int64_t period_ns
+    );
+    thread_attributes & affinity (std::initializer_list<int> cpus);
+    thread_attributes & affinity (const std::vector<int> & cpus);
+    thread_attributes & name (const std::string & n);
+    thread_attributes & prefault_stack (std::size_t bytes);
+    thread_attributes & best_effort (bool flag = true);
+
+    thread_status apply () const;
+    thread_status launch (std::thread & t, std::function<void ()> body) const;
+
+private:
+
+    thread_status validate () const;
+    thread_status apply_name () const;
+    thread_status apply_affinity () const;
+    thread_status apply_stack () const;
+    thread_status apply_policy () const;
+
+};          // class thread_attributes
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_THREADATTRIBUTES_HPP
+
+/*
+ * threadattributes.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,200 @@
+#if ! defined XPC66_XPC_TIMERSERVICE_HPP
+#define XPC66_XPC_TIMERSERVICE_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timerservice.hpp
+ *
+ *  This module declares a set of timers behind one pollable descriptor,
+ *  so that an I/O thread can wait for timers and sockets together.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  microsleep() and millisleep() block the thread, so a thread cannot
+ *  sleep until a timer is due and also watch its sockets.  The
+ *  timer_service keeps any number of one-shot and periodic timers, with
+ *  absolute deadlines on the nanotime() (CLOCK_MONOTONIC) scale, and
+ *  keeps one Linux timerfd(2) armed for the earliest of them.  The
+ *  descriptor becomes readable when a timer is due:
+ *
+\verbatim
+        xpc::timer_service timers;
+        timers.add_periodic(xpc::nanotime(), 10000, [&] { send_keepalive(); });
+        add timers.fd() to the epoll set, with EPOLLIN
+        ...
+        for (;;)
+        {
+            epoll_wait(...);
+            if (the timer fd is readable)
+                timers.dispatch();              // runs the due callbacks
+            ... handle the sockets ...
+        }
+\endverbatim
+ *
+ *  Being a waitable, it also works with wait_any().  Timers can be added
+ *  and cancelled from any thread; the callbacks run in the thread that
+ *  calls dispatch(), without the service's lock held, so they may add or
+ *  cancel timers themselves.
+ *
+ *  A periodic timer keeps its phase.  If dispatch() is called late, each
+ *  timer runs once, and deadlines that passed entirely are skipped (and
+ *  counted in missed()), as in periodic_timer.
+ *
+ *  timerfd is Linux-only.  Elsewhere fd() is -1, and the owner must call
+ *  dispatch() itself, by next_deadline_ns().
+ */
+
+#include <cstdint>                      /* std::int64_t, std::uint64_t      */
+#include <functional>                   /* std::function<>                  */
+#include <map>                          /* std::map<>                       */
+#include <mutex>                        /* std::mutex                       */
+#include <set>                          /* std::set<>                       */
+#include <utility>                      /* std::pair<>                      */
+
+#include "xpc/waitable.hpp"             /* xpc::waitable base class         */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  Many timers multiplexed onto one timerfd.
+ */
+
+class timer_service : public waitable
+{
+
+public:
+
+    using callback = std::function<void ()>;
+
+    /**
+     *  Identifies a timer, for cancel().  Ids are never reused; 0 is never
+     *  valid.
+     */
+
+    using timer_id = std::uint64_t;
+
+private:
+
+    struct entry
+    {
+        std::int64_t deadline;          /* the next deadline, nanotime()    */
+        std::int64_t period;            /* 0 for a one-shot timer           */
+        callback function;
+    };
+
+    /**
+     *  The timerfd, or -1.
+     */
+
+    int m_fd;
+
+    /**
+     *  Guards everything below.
+     */
+
+    mutable std::mutex m_mutex;
+
+    std::map<timer_id, entry> m_timers;
+
+    /**
+     *  The timers ordered by deadline.
+     */
+
+    std::set<std::pair<std::int64_t, timer_id>> m_queue;
+
+    timer_id m_next_id;
+
+    /**
+     *  The deadline the timerfd is armed for, or 0 if disarmed.
+     */
+
+    std::int64_t m_armed_ns;
+
+    /**
+     *  Periodic deadlines skipped because dispatch() came too late.
+     */
+
+    std::int64_t m_missed;
+
+public:
+
+    timer_service ();
+    timer_service (const timer_service &) = delete;
+    timer_service & operator = (const timer_service &) = delete;
+    virtual ~timer_service ();
+
+    bool valid () const
+    {
+        return m_fd >= 0;
+    }
+
+    /**
+     *  The descriptor to wait on for readability.  The caller must not read
+     *  or close it; use dispatch().
+     */
+
+    int fd () const
+    {
+        return m_fd;
+    }
+
+    virtual int wait_fd () const override
+    {
+        return m_fd;
+    }
+
+    timer_id add_oneshot_at (std::int64_t deadline_ns, callback f);
+    timer_id add_oneshot (int delay_us, callback f);
+    timer_id add_periodic
+    (
+        std::int64_t first_deadline_ns, int period_us, callback f
+    );
+    bool cancel (timer_id id);
+    int dispatch ();
+
+    std::int64_t next_deadline_ns () const;
+    std::size_t count () const;
+    std::int64_t missed () const;
+
+private:
+
+    timer_id add (std::int64_t deadline, std::int64_t period, callback f);
+    void rearm ();
+
+};          // class timer_service
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_TIMERSERVICE_HPP
+
+/*
+ * timerservice.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
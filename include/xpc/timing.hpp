@@ -23,7 +23,7 @@
  * \file          timing.hpp
  * \author        Chris Ahlstrom
  * \date          2005-07-03 to 2007-08-21 (from xpc-suite project)
- * \updates       2022-07-03
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *    Daemonization of POSIX C Wrapper (PSXC) library
@@ -31,8 +31,18 @@
  *
  *    This module provides functions for timing and increasing thread
  *    priority.
+ *
+ *    The precise_*() functions sleep for most of the interval and then spin
+ *    for the last few microseconds, for deadlines (such as MIDI clock) that
+ *    a plain sleep overshoots.
+ *
+ *    nanotime(), microtime(), and millitime() read the same monotonic
+ *    clock as std::chrono::steady_clock, so the inline helpers below can
+ *    convert between their values and steady_clock time points.
  */
 
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdint>                      /* std::int64_t                     */
 #include <thread>                       /* std::thread                      */
 
 /*
@@ -42,6 +52,8 @@
 namespace xpc
 {
 
+class stop_token;
+
 /*
  *  Free functions for Linux and Windows support.
  */
@@ -49,11 +61,65 @@ namespace xpc
 extern int std_sleep_us ();
 extern bool microsleep (int us);
 extern bool millisleep (int ms);
+extern bool microsleep (int us, const stop_token & token);
+extern bool millisleep (int ms, const stop_token & token);
 extern void thread_yield ();
-extern long microtime ();
-extern long millitime ();
+extern std::int64_t nanotime ();
+extern std::int64_t microtime ();
+extern std::int64_t millitime ();
 extern bool set_thread_priority (std::thread & t, int p = 1);
 extern bool set_timer_services (bool on);
+extern long timer_slack_ns ();
+extern bool set_timer_slack_ns (long ns);
+extern bool precise_microsleep (int us);
+extern void sleep_until_ns (std::int64_t deadline_ns);
+extern bool precise_sleep_until_ns (std::int64_t deadline_ns);
+extern int precise_margin_us ();
+extern int calibrate_precise_sleep ();
+
+/*
+ *  Conversions between nanotime() values and std::chrono types.
+ */
+
+inline std::chrono::nanoseconds
+nanotime_duration (std::int64_t ns)
+{
+    return std::chrono::nanoseconds(ns);
+}
+
+inline std::chrono::steady_clock::time_point
+nanotime_to_time_point (std::int64_t ns)
+{
+    return std::chrono::steady_clock::time_point
+    (
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>
+        (
+            std::chrono::nanoseconds(ns)
+        )
+    );
+}
+
+inline std::int64_t
+time_point_to_nanotime (std::chrono::steady_clock::time_point tp)
+{
+    return std::int64_t
+    (
+        std::chrono::duration_cast<std::chrono::nanoseconds>
+        (
+            tp.time_since_epoch()
+        ).count()
+    );
+}
+
+template <typename REP, typename PERIOD>
+inline std::int64_t
+to_nanoseconds (std::chrono::duration<REP, PERIOD> d)
+{
+    return std::int64_t
+    (
+        std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()
+    );
+}
 
 }        // namespace xpc
 
@@ -0,0 +1,209 @@
+#if ! defined XPC66_XPC_TIMINGWHEEL_HPP
+#define XPC66_XPC_TIMINGWHEEL_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timingwheel.hpp
+ *
+ *  This module declares a hierarchical timing wheel, for thousands of
+ *  pending timeouts (note durations, retries, LFO steps).
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Checking every pending deadline against the clock on each pass costs
+ *  O(n) per pass.  The wheel files each timer in a slot by its expiry
+ *  tick, so that scheduling and cancelling are O(1), and each tick looks
+ *  at only one slot.  There are four levels of 256 slots.  Level 0 holds
+ *  the timers due in the next 256 ticks, level 1 the next 65536, and so
+ *  on; when level 0 wraps, the next level-1 slot is "cascaded" down into
+ *  it (as in the classic Linux kernel timers).  With 1 ms ticks, the
+ *  longest delay is about 49 days.
+ *
+ *  Timers live in a pool that is allocated by the constructor, and the
+ *  callbacks are plain function pointers with a data pointer, so that
+ *  scheduling never allocates.  All of the timers due in a tick are
+ *  unlinked as one batch, and then their callbacks are run.  A callback
+ *  may schedule or cancel timers, including itself.
+ *
+ *  The wheel is driven by nanotime().  The owner thread calls advance()
+ *  regularly (e.g. once per engine cycle); it is not thread-safe.
+ *
+\verbatim
+        static void note_off (void * data);
+        xpc::timing_wheel wheel(4096);          // 4096 timers, 1 ms ticks
+        auto id = wheel.schedule(250000, note_off, &note);
+        ...
+        wheel.cancel(id);                       // if the note was retriggered
+        ... in the engine loop ...
+        wheel.advance();                        // runs the due callbacks
+\endverbatim
+ */
+
+#include <cstdint>                      /* std::int64_t, std::uint64_t      */
+#include <vector>                       /* std::vector<>                    */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  A hierarchical timing wheel with a fixed-size pool of timers.
+ */
+
+class timing_wheel
+{
+
+public:
+
+    /**
+     *  The callback type.  The data pointer is the one given to
+     *  schedule().
+     */
+
+    using callback = void (*) (void * data);
+
+    /**
+     *  Identifies a scheduled timer, for cancel().  It includes a
+     *  generation count, so an old id never cancels a newer timer that
+     *  reuses the same pool entry.  Zero is never a valid id.
+     */
+
+    using timer_id = std::uint64_t;
+
+    static const int c_level_bits = 8;
+    static const int c_levels = 4;
+    static const int c_slots = 1 << c_level_bits;
+
+private:
+
+    /**
+     *  A timer.  Timers are linked into lists by pool index.
+     */
+
+    struct node
+    {
+        std::int32_t prev;
+        std::int32_t next;
+        std::int32_t list;              /* the list holding it, or -1       */
+        std::uint32_t generation;
+        std::uint64_t expires;          /* the tick it is due in            */
+        callback function;
+        void * data;
+    };
+
+    /**
+     *  The heads of the lists: c_levels * c_slots slots, then the list of
+     *  timers expiring in the current tick, then the free list.
+     */
+
+    static const int c_expiring_list = c_levels * c_slots;
+    static const int c_free_list = c_expiring_list + 1;
+    static const int c_list_count = c_free_list + 1;
+
+    std::vector<node> m_pool;
+    std::vector<std::int32_t> m_heads;
+
+    /**
+     *  The tick length in nanoseconds.
+     */
+
+    std::int64_t m_tick_ns;
+
+    /**
+     *  The nanotime() of tick 0.
+     */
+
+    std::int64_t m_start_ns;
+
+    /**
+     *  The next tick to be processed.
+     */
+
+    std::uint64_t m_current;
+
+    /**
+     *  The number of scheduled timers.
+     */
+
+    std::size_t m_pending;
+
+public:
+
+    explicit timing_wheel (std::size_t capacity, int tick_us = 1000);
+    timing_wheel (const timing_wheel &) = delete;
+    timing_wheel & operator = (const timing_wheel &) = delete;
+    ~timing_wheel () = default;
+
+    timer_id schedule (std::int64_t delay_us, callback f, void * data);
+    timer_id schedule_at (std::int64_t deadline_ns, callback f, void * data);
+    bool cancel (timer_id id);
+    int advance ();
+    int advance (std::int64_t now_ns);
+
+    std::size_t pending () const
+    {
+        return m_pending;
+    }
+
+    std::size_t capacity () const
+    {
+        return m_pool.size();
+    }
+
+    int tick_us () const
+    {
+        return int(m_tick_ns / 1000);
+    }
+
+    /**
+     *  The nanotime() at which tick 0 starts; tick n starts at
+     *  start_ns() + n * tick_us() * 1000.
+     */
+
+    std::int64_t start_ns () const
+    {
+        return m_start_ns;
+    }
+
+private:
+
+    void link (std::int32_t index, int list);
+    void unlink (std::int32_t index);
+    void file (std::int32_t index);
+    int cascade (int level, int slot);
+
+};          // class timing_wheel
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_TIMINGWHEEL_HPP
+
+/*
+ * timingwheel.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,118 @@
+#if ! defined XPC66_XPC_WAITABLE_HPP
+#define XPC66_XPC_WAITABLE_HPP
+
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          waitable.hpp
+ *
+ *  This module declares the base class for xpc objects that a thread can
+ *  wait on together, and the wait_any() function that does the waiting.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  In the spirit of the Windows WaitForMultipleObjects(), a worker can block
+ *  until whichever comes first of new ring-buffer data, a shutdown request,
+ *  or a timeout, without polling each in turn:
+ *
+\verbatim
+        xpc::notifier ringdata;
+        ring.attach(&ringdata);
+        xpc::stop_token stop = xpc::session_stop_token();
+        for (;;)
+        {
+            int which = xpc::wait_any({&ringdata, stop.get_waitable()}, 5);
+            if (which == 0)
+            {
+                ringdata.drain();
+                ... consume the ring ...
+            }
+            else if (which == 1)
+                break;                          // shutting down
+            else
+                ... 5 ms with nothing to do ...
+        }
+\endverbatim
+ *
+ *  Each waitable object is backed by a file descriptor that is readable
+ *  while the object is "ready", and wait_any() is a single poll(2) call.
+ *  wait_any() does not consume anything; the caller does that (for example
+ *  with notifier::drain()) after it learns which object is ready.
+ *
+ *  POSIX-only.
+ */
+
+#include <initializer_list>             /* std::initializer_list<>          */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  An object that can be waited on with wait_any().
+ */
+
+class waitable
+{
+
+public:
+
+    waitable () = default;
+    waitable (const waitable &) = delete;
+    waitable & operator = (const waitable &) = delete;
+    virtual ~waitable () = default;
+
+    /**
+     *  Returns a descriptor that is readable while the object is ready, or
+     *  -1 if the object is not usable.
+     */
+
+    virtual int wait_fd () const = 0;
+
+};          // class waitable
+
+/*
+ *  Free functions in the waitable module.
+ */
+
+extern int wait_any
+(
+    std::initializer_list<const waitable *> objects, int timeout_ms = -1
+);
+extern int wait_any
+(
+    const waitable * const * objects, int count, int timeout_ms = -1
+);
+
+}           // namespace xpc
+
+#endif      // XPC66_XPC_WAITABLE_HPP
+
+/*
+ * waitable.hpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,204 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          barrier.cpp
+ *
+ *  This module defines the barrier and latch classes.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  The barrier, phase by phase:
+ *
+ *      -#  Each thread reads the phase number, then increments m_arrived.
+ *          Reading the phase first matters: once m_arrived is full, the
+ *          phase can change at any moment.
+ *      -#  The last thread resets m_arrived, runs the completion function,
+ *          and increments the phase (release), which frees the others.
+ *          Nobody can arrive for the next phase before that, so the reset
+ *          cannot be confused with a new arrival.
+ *      -#  The others wait for the phase to change (acquire), so that they
+ *          see everything done before the barrier, including the completion
+ *          function's work.
+ *
+ *  The sleeper count keeps futex_wake() off the fast path, as in the
+ *  semaphore module.
+ */
+
+#include "xpc/barrier.hpp"              /* xpc::barrier, xpc::latch         */
+#include "xpc/futex.hpp"                /* xpc::futex_wait(), futex_wake()  */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+namespace
+{
+
+/**
+ *  The number of times a waiter polls before going to sleep.
+ */
+
+const int c_spin_limit = 200;
+
+/**
+ *  Waits while the word holds the given value, spinning, then sleeping.
+ */
+
+void
+wait_while_equal (std::atomic<int> & word, std::atomic<int> & sleepers, int v)
+{
+    int limit = spin_worthwhile() ? c_spin_limit : 0 ;
+    for (int spin = 0; spin < limit; ++spin)
+    {
+        if (word.load(std::memory_order_acquire) != v)
+            return;
+
+        cpu_relax();
+    }
+    while (word.load(std::memory_order_acquire) == v)
+    {
+        sleepers.fetch_add(1);
+        (void) futex_wait(word, v);
+        sleepers.fetch_sub(1);
+    }
+}
+
+}           // anonymous namespace
+
+/*
+ * --------------------------------------------------------------------------
+ *  barrier
+ * --------------------------------------------------------------------------
+ */
+
+/**
+ * \param count
+ *      The number of threads that must arrive to end each phase.
+ *
+ * \param c
+ *      An optional function, run by the last thread to arrive in each
+ *      phase, while the others are still held.
+ */
+
+barrier::barrier (int count, completion c) :
+    m_count         (count > 0 ? count : 1),
+    m_completion    (c),
+    m_arrived       (0),
+    m_phase         (0),
+    m_sleepers      (0)
+{
+    // no code
+}
+
+/**
+ *  Arrives at the barrier, and waits until all of the threads have.
+ *
+ * \return
+ *      Returns true for the one thread that completed the phase (as with
+ *      PTHREAD_BARRIER_SERIAL_THREAD), false for the others.
+ */
+
+bool
+barrier::arrive_and_wait ()
+{
+    int phase = m_phase.load(std::memory_order_acquire);
+    if (m_arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count)
+    {
+        m_arrived.store(0, std::memory_order_relaxed);
+        if (m_completion)
+            m_completion();
+
+        m_phase.fetch_add(1);
+        if (m_sleepers.load() > 0)
+            futex_wake_all(m_phase);
+
+        return true;
+    }
+    wait_while_equal(m_phase, m_sleepers, phase);
+    return false;
+}
+
+/*
+ * --------------------------------------------------------------------------
+ *  latch
+ * --------------------------------------------------------------------------
+ */
+
+latch::latch (int count) :
+    m_count     (count > 0 ? count : 0),
+    m_sleepers  (0)
+{
+    // no code
+}
+
+/**
+ *  Decrements the count, releasing the waiters when it reaches zero.
+ */
+
+void
+latch::count_down (int n)
+{
+    int previous = m_count.fetch_sub(n);
+    if (previous > 0 && previous - n <= 0)
+    {
+        if (m_sleepers.load() > 0)
+            futex_wake_all(m_count);
+    }
+}
+
+/**
+ *  Waits until the count reaches zero.  Each count_down() changes the
+ *  futex word, so a sleeper may wake early; it just sleeps again on the
+ *  new value.
+ */
+
+void
+latch::wait ()
+{
+    for (;;)
+    {
+        int c = m_count.load(std::memory_order_acquire);
+        if (c <= 0)
+            return;
+
+        wait_while_equal(m_count, m_sleepers, c);
+    }
+}
+
+void
+latch::arrive_and_wait (int n)
+{
+    count_down(n);
+    wait();
+}
+
+}           // namespace xpc
+
+/*
+ * barrier.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
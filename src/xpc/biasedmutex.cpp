@@ -0,0 +1,222 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          biasedmutex.cpp
+ *
+ *  This module defines the slow paths of the biasedmutex.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Why it works.  The owner does "busy = 1; barrier; read revoked", and a
+ *  guest does "revoked = 1; barrier; read busy".  If both barriers are
+ *  full fences, at least one side sees the other's store (Dekker).  The
+ *  owner's compiler barrier alone only keeps the compiler from reordering;
+ *  membarrier() supplies the missing hardware fence, on the owner's CPU,
+ *  at the moment the guest needs it.
+ *
+ *  The membarrier constants are spelled out, since older kernel headers
+ *  define the system call but not the expedited commands (Linux 4.14).
+ */
+
+#include <thread>                       /* std::this_thread::yield()        */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/biasedmutex.hpp"          /* xpc::biasedmutex                 */
+
+#if defined PLATFORM_LINUX
+#include <sys/syscall.h>                /* SYS_membarrier                   */
+#include <unistd.h>                     /* syscall()                        */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+namespace
+{
+
+/**
+ *  The number of times a guest polls the owner's flag before yielding.
+ */
+
+const int c_spin_limit = 100;
+
+#if defined PLATFORM_LINUX && defined SYS_membarrier
+
+const int c_membarrier_query                        = 0;
+const int c_membarrier_private_expedited            = 1 << 3;
+const int c_membarrier_register_private_expedited   = 1 << 4;
+
+long
+sys_membarrier (int cmd)
+{
+    return syscall(SYS_membarrier, cmd, 0);
+}
+
+/**
+ *  Checks for the expedited command, and registers the process for it,
+ *  which the kernel requires before the first use.
+ */
+
+bool
+membarrier_setup ()
+{
+    long cmds = sys_membarrier(c_membarrier_query);
+    if (cmds < 0 || (cmds & c_membarrier_private_expedited) == 0)
+        return false;
+
+    return sys_membarrier(c_membarrier_register_private_expedited) == 0;
+}
+
+#else
+
+bool
+membarrier_setup ()
+{
+    return false;
+}
+
+#endif
+
+}           // anonymous namespace
+
+/**
+ *  Tells if the asymmetric mode is possible.  The check (and registration)
+ *  is done once per process.
+ */
+
+bool
+biasedmutex::membarrier_available ()
+{
+    static const bool s_available = membarrier_setup();
+    return s_available;
+}
+
+biasedmutex::biasedmutex () :
+    m_owner_busy    (0),
+    m_owner_slow    (false),
+    m_revoked       (0),
+    m_guest_mutex   (),
+    m_asymmetric    (membarrier_available())
+{
+    // no code
+}
+
+/**
+ *  Issues the guest's half of the barrier pair.
+ */
+
+void
+biasedmutex::serialize ()
+{
+#if defined PLATFORM_LINUX && defined SYS_membarrier
+    if (m_asymmetric)
+    {
+        (void) sys_membarrier(c_membarrier_private_expedited);
+        return;
+    }
+#endif
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/**
+ *  The owner found a guest holding, or waiting for, the lock.  It backs off
+ *  (which frees a waiting guest) and then queues on the guest mutex like
+ *  anyone else.  Holding that mutex keeps other guests out until
+ *  owner_unlock().
+ */
+
+void
+biasedmutex::owner_lock_slow ()
+{
+    m_owner_busy.store(0, std::memory_order_release);
+    m_guest_mutex.lock();
+    m_owner_slow = true;
+}
+
+/**
+ *  Locks for any thread but the owner.  The wait for the owner's flag is
+ *  at most one of its critical sections, which should be short.
+ */
+
+void
+biasedmutex::lock ()
+{
+    m_guest_mutex.lock();
+    m_revoked.store(1, std::memory_order_relaxed);
+    serialize();
+
+    int limit = spin_worthwhile() ? c_spin_limit : 0 ;
+    int spin = 0;
+    while (m_owner_busy.load(std::memory_order_acquire) != 0)
+    {
+        if (spin < limit)
+        {
+            ++spin;
+            cpu_relax();
+        }
+        else
+            std::this_thread::yield();
+    }
+}
+
+void
+biasedmutex::unlock ()
+{
+    m_revoked.store(0, std::memory_order_release);
+    m_guest_mutex.unlock();
+}
+
+/**
+ * \return
+ *      Returns true if the lock was taken, false if another guest holds it
+ *      or the owner is inside its critical section.
+ */
+
+bool
+biasedmutex::try_lock ()
+{
+    if (! m_guest_mutex.try_lock())
+        return false;
+
+    m_revoked.store(1, std::memory_order_relaxed);
+    serialize();
+    if (m_owner_busy.load(std::memory_order_acquire) != 0)
+    {
+        m_revoked.store(0, std::memory_order_release);
+        m_guest_mutex.unlock();
+        return false;
+    }
+    return true;
+}
+
+}           // namespace xpc
+
+/*
+ * biasedmutex.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,226 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          coarseclock.cpp
+ *
+ *  This module defines the coarse and cached clocks.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  The updater thread sleeps with microsleep(period, token), so that
+ *  cached_clock::stop() ends it at once.  A static clock_updater object
+ *  stops it at exit, since destroying a joinable std::thread would call
+ *  std::terminate().
+ */
+
+#include <mutex>                        /* std::mutex, std::lock_guard<>    */
+#include <thread>                       /* std::thread                      */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/coarseclock.hpp"          /* xpc::coarse_nanotime(), etc.     */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_source                 */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), microsleep()    */
+
+#if defined PLATFORM_LINUX
+#include <time.h>                       /* CLOCK_MONOTONIC_COARSE           */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/*
+ * --------------------------------------------------------------------------
+ *  Coarse clock
+ * --------------------------------------------------------------------------
+ */
+
+#if defined PLATFORM_LINUX && defined CLOCK_MONOTONIC_COARSE
+
+/**
+ *  Gets the monotonic time as of the last timer tick.  It is on the same
+ *  scale as nanotime(), but up to coarse_resolution_ns() behind it.
+ */
+
+std::int64_t
+coarse_nanotime ()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &t);
+    return std::int64_t(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+/**
+ *  Gets the resolution of coarse_nanotime(), normally the kernel's tick
+ *  period, 1 to 10 ms.
+ */
+
+std::int64_t
+coarse_resolution_ns ()
+{
+    struct timespec r;
+    if (clock_getres(CLOCK_MONOTONIC_COARSE, &r) != 0)
+        return 0;
+
+    return std::int64_t(r.tv_sec) * 1000000000 + r.tv_nsec;
+}
+
+#else
+
+std::int64_t
+coarse_nanotime ()
+{
+    return nanotime();
+}
+
+std::int64_t
+coarse_resolution_ns ()
+{
+    return 1;
+}
+
+#endif
+
+std::int64_t
+coarse_millitime ()
+{
+    return coarse_nanotime() / 1000000;
+}
+
+/*
+ * --------------------------------------------------------------------------
+ *  Cached clock
+ * --------------------------------------------------------------------------
+ */
+
+std::atomic<std::int64_t> cached_clock::sm_nanotime { 0 };
+
+/**
+ *  Owns the updater thread.
+ */
+
+class clock_updater
+{
+
+private:
+
+    std::mutex m_mutex;
+    std::thread m_thread;
+    stop_source m_stopper;
+
+public:
+
+    clock_updater () = default;
+
+    ~clock_updater ()
+    {
+        stop();
+    }
+
+    bool start (int period_us)
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_thread.joinable())
+            return true;
+
+        if (period_us <= 0)
+            period_us = 1000;
+
+        m_stopper = stop_source();
+        cached_clock::update(nanotime());
+        m_thread = std::thread
+        (
+            [period_us] (stop_token token)
+            {
+                while (microsleep(period_us, token))
+                    cached_clock::update(nanotime());
+            },
+            m_stopper.get_token()
+        );
+        return true;
+    }
+
+    void stop ()
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (m_thread.joinable())
+        {
+            (void) m_stopper.request_stop();
+            m_thread.join();
+            cached_clock::update(0);
+        }
+    }
+
+};          // class clock_updater
+
+namespace
+{
+
+clock_updater &
+updater ()
+{
+    static clock_updater s_updater;
+    return s_updater;
+}
+
+}           // anonymous namespace
+
+/**
+ *  Starts the updater thread, if it is not already running.  The cached
+ *  time is valid as soon as this returns.
+ *
+ * \param period_us
+ *      How often to refresh the time, which is also its resolution.  The
+ *      default is 1000 us.
+ *
+ * \return
+ *      Returns true if the thread is running.
+ */
+
+bool
+cached_clock::start (int period_us)
+{
+    return updater().start(period_us);
+}
+
+/**
+ *  Stops the updater thread.  The readers then fall back to
+ *  coarse_nanotime().
+ */
+
+void
+cached_clock::stop ()
+{
+    updater().stop();
+}
+
+}           // namespace xpc
+
+/*
+ * coarseclock.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
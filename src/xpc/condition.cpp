@@ -24,7 +24,7 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2024-04-17
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  2019-04-21 Reverted to commit 5b125f71 to stop GUI deadlock :-(
@@ -34,13 +34,28 @@
  *  issues such as freezing the user interfaces.  For now, even though we don't
  *  have to hide it, we using the "pimpl" paradigm to use a pthreads
  *  implementation.  See the Doxygen documentation for more information.
+ *
+ *  Timed waits:  pthread_cond_timedwait() takes an absolute deadline, not a
+ *  relative time, measured by the condition's clock.  We set that clock to
+ *  CLOCK_MONOTONIC where pthread_condattr_setclock() exists, so that a change
+ *  to the wall-clock time does not lengthen or shorten a wait.  macOS lacks
+ *  it, so there the deadline is on CLOCK_REALTIME.
  */
 
+#include <cerrno>                       /* ETIMEDOUT                        */
+#include <ctime>                        /* clock_gettime(), CLOCK_MONOTONIC */
 #include <memory>                       /* std::make_unique()               */
 #include <pthread.h>                    /* pthread_cond_t and functions     */
 
 #include "xpc/condition.hpp"            /* xpc::condition & synchronizer    */
 
+#if defined PLATFORM_MACOSX
+#define XPC66_CONDITION_CLOCK   CLOCK_REALTIME
+#else
+#define XPC66_CONDITION_CLOCK   CLOCK_MONOTONIC
+#define XPC66_HAVE_CONDATTR_SETCLOCK
+#endif
+
 /*
  *  Do not document a namespace; it breaks Doxygen.
  */
@@ -62,18 +77,13 @@ private:
     using variable = pthread_cond_t;
 
     /**
-     *  We need a global condition-variable so that it can coordinate threads
-     *  in different objects.
-     */
-
-    static variable sm_cond;
-
-    /**
-     *  Provides a class-specific way to wait for a condition to change.  It
-     *  is normally set to the static variable sm_cond.
+     *  This condition's own condition variable.  It used to be a reference
+     *  to one static variable shared by every condition, so that a signal()
+     *  on one condition could wake (and use up) a waiter on an unrelated one,
+     *  while the intended waiter slept on.
      */
 
-    variable & m_cond;
+    variable m_cond;
 
     /**
      *  Access to the outer class's recmutex.
@@ -83,13 +93,27 @@ private:
 
 public:
 
-    impl (recmutex & rm) : m_cond (sm_cond), m_rec_mutex (rm)
+    impl (recmutex & rm) : m_cond (), m_rec_mutex (rm)
+    {
+        pthread_condattr_t attributes;
+        pthread_condattr_init(&attributes);
+#if defined XPC66_HAVE_CONDATTR_SETCLOCK
+        pthread_condattr_setclock(&attributes, XPC66_CONDITION_CLOCK);
+#endif
+        pthread_cond_init(&m_cond, &attributes);
+        pthread_condattr_destroy(&attributes);
+    }
+
+    impl (const impl &) = delete;
+    impl & operator = (const impl &) = delete;
+
+    ~impl ()
     {
-        // no code
+        pthread_cond_destroy(&m_cond);
     }
 
     /**
-     *  Signals the condition variable.
+     *  Wakes one waiter, if any.
      */
 
     void signal ()
@@ -97,6 +121,15 @@ public:
         pthread_cond_signal(&m_cond);
     }
 
+    /**
+     *  Wakes all waiters.
+     */
+
+    void broadcast ()
+    {
+        pthread_cond_broadcast(&m_cond);
+    }
+
     /**
      *  Waits for the condition variable.  If we use std::condition_variable,
      *  we would need to provide a non-recursive mutex for locking.  This
@@ -109,25 +142,36 @@ public:
     }
 
     /**
-     *  Nanoseconds:  convert milliseconds to microsecond
+     *  Waits until the given number of nanoseconds from now, at most.  The
+     *  deadline is on the condition's own clock.  The old code passed the
+     *  relative time itself, a deadline long past, so every timed wait
+     *  returned at once and callers' wait loops became busy loops.
+     *
+     * \return
+     *      Returns true if the wait timed out, false if it was woken
+     *      (perhaps spuriously).
      */
 
-    void wait (int ms)
+    bool wait_ns (long long ns)
     {
-        struct timespec w;
-        w.tv_sec = long(ms / 1000);
-        w.tv_nsec = long((ms * 1000) % 1000000) * 1000;
-        pthread_cond_timedwait(&m_cond, &(m_rec_mutex.native_locker()), &w);
+        if (ns <= 0)
+            return true;
+
+        const long long billion = 1000000000LL;
+        struct timespec deadline;
+        clock_gettime(XPC66_CONDITION_CLOCK, &deadline);
+        long long nsec = (long long)(deadline.tv_nsec) + ns % billion;
+        deadline.tv_sec += time_t(ns / billion + nsec / billion);
+        deadline.tv_nsec = long(nsec % billion);
+        int rc = pthread_cond_timedwait
+        (
+            &m_cond, &(m_rec_mutex.native_locker()), &deadline
+        );
+        return rc == ETIMEDOUT;
     }
 
 };          // class mutex::impl for pthreads
 
-/**
- *  Define the static condition variable used by all mutex locks.
- */
-
-condition::impl::variable condition::impl::sm_cond;
-
 /*
  * --------------------------------------------------------------------------
  *  condition class p_imple wrapper
@@ -135,7 +179,7 @@ condition::impl::variable condition::impl::sm_cond;
  */
 
 /**
- *  Initialize the condition variable with the global variable.
+ *  Each condition gets its own condition variable.
  */
 
 condition::condition () :
@@ -152,14 +196,18 @@ condition::condition (const condition & /* rhs */) :
     // Empty body
 }
 
+/**
+ *  The condition variable is not copied:  this condition keeps its own, and
+ *  with it any threads waiting on it.  (The old code reset p_imple to the
+ *  raw pointer of a temporary unique_ptr, a double delete.)
+ */
+
 condition &
 condition::operator = (const condition & rhs)
 {
     if (this != & rhs)
-    {
         m_mutex_lock = rhs.m_mutex_lock;
-        p_imple.reset(std::make_unique<condition::impl>(m_mutex_lock).get());
-    }
+
     return *this;
 }
 
@@ -175,16 +223,98 @@ condition::signal ()
     p_imple->signal();
 }
 
+void
+condition::broadcast ()
+{
+    p_imple->broadcast();
+}
+
 void
 condition::wait ()
 {
     p_imple->wait();
 }
 
-void
+/**
+ *  Waits for a signal, or for the given time to pass.
+ *
+ * \param ms
+ *      The longest wait, in milliseconds.  Zero or less does not wait.
+ *
+ * \return
+ *      Returns true if the wait timed out.  A false return means the
+ *      condition was signalled, or the wakeup was spurious, so the caller
+ *      should check its state.
+ */
+
+bool
 condition::wait (int ms)
 {
-    p_imple->wait(ms);
+    return p_imple->wait_ns((long long)(ms) * 1000000LL);
+}
+
+/**
+ *  Waits for a signal, or for a stop to be requested.  A stop_callback
+ *  broadcasts on this condition, taking the lock first so that the wakeup
+ *  cannot slip in between our check of the token and the wait.
+ *
+ *  Before the callback is unregistered, we let go of the lock, and take it
+ *  back afterward.  Otherwise a request_stop() running the callback (which
+ *  is blocked on our lock) and our unregistering (which waits for the
+ *  callback to finish) would deadlock.  Since any wakeup can be spurious,
+ *  the caller re-checks its state after the wait anyway.
+ *
+ * \return
+ *      Returns false if a stop was requested, true otherwise.
+ */
+
+bool
+condition::wait (const stop_token & token)
+{
+    if (token.stop_requested())
+        return false;
+
+    {
+        stop_callback wakeup
+        (
+            token, [this] ()
+            {
+                lock();
+                broadcast();
+                unlock();
+            }
+        );
+        if (! token.stop_requested())
+            wait();
+
+        unlock();
+    }
+    lock();
+    return ! token.stop_requested();
+}
+
+/**
+ *  Waits for a signal, or until the deadline passes.  The steady_clock
+ *  deadline is converted to a time remaining, and then to a deadline on the
+ *  condition's clock, which on most systems is the same monotonic clock.
+ *
+ * \return
+ *      Returns true if the deadline has passed.
+ */
+
+bool
+condition::wait_until (std::chrono::steady_clock::time_point deadline)
+{
+    auto remaining = deadline - std::chrono::steady_clock::now();
+    long long ns = (long long)
+    (
+        std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count()
+    );
+    bool result = p_imple->wait_ns(ns);
+    if (! result)
+        result = std::chrono::steady_clock::now() >= deadline;
+
+    return result;
 }
 
 /*
@@ -208,28 +338,287 @@ condition::wait (int ms)
  *          c-core-guidelines-be-aware-of-the-traps-of-condition-variables
  */
 
-synchronizer::synchronizer () :
+/**
+ * \param atomic_predicate
+ *      If true, signal() skips the lock and the notify when nobody waits.
+ *      Pass true only if predicate() tests nothing but std::atomic state
+ *      written with the default (seq_cst) memory order.  See the class
+ *      description.
+ */
+
+synchronizer::synchronizer (bool atomic_predicate) :
     m_helper_mutex      (),
-    m_condition_var     ()
+    m_condition_var     (),
+    m_atomic_predicate  (atomic_predicate),
+    m_waiters           (0),
+    m_pending           (0),
+    m_pending_since     (0),
+    m_batch_count       (0),
+    m_batch_us          (0)
 {
     // no other code
 }
 
+/*
+ *  Waiter bookkeeping for the signal() fast path.
+ */
+
+namespace
+{
+
+/**
+ *  Counts a thread as a waiter for the life of the object.  It is created
+ *  before the predicate is first tested, so the increment (a sequentially
+ *  consistent read-modify-write) comes before the predicate's loads.
+ */
+
+class waiter_count
+{
+
+private:
+
+    std::atomic<int> & m_count;
+
+public:
+
+    waiter_count (std::atomic<int> & c) : m_count (c)
+    {
+        m_count.fetch_add(1);
+    }
+
+    ~waiter_count ()
+    {
+        m_count.fetch_sub(1);
+    }
+
+};
+
+long long
+steady_microseconds ()
+{
+    return (long long) std::chrono::duration_cast<std::chrono::microseconds>
+    (
+        std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+}
+
+}           // anonymous namespace
+
+/**
+ *  Waits until predicate() is true.  When batching with a time limit, the
+ *  wait is done in steps of that time, so that a batch left pending by a
+ *  producer that has gone quiet delays us by at most that long.
+ */
+
 bool
 synchronizer::wait ()
 {
     std::unique_lock<std::mutex> locker(m_helper_mutex);
-    m_condition_var.wait(locker, [this]{ return predicate(); });
+    waiter_count counter(m_waiters);
+    if (m_batch_count > 1 && m_batch_us > 0)
+    {
+        auto step = std::chrono::microseconds(m_batch_us);
+        auto pred = [this]{ return predicate(); };
+        while (! m_condition_var.wait_for(locker, step, pred))
+        {
+            // keep waiting
+        }
+    }
+    else
+        m_condition_var.wait(locker, [this]{ return predicate(); });
+
+    return predicate();
+}
+
+/**
+ *  Like wait(), but also returns when a stop is requested on the token.
+ *  The stop_callback is declared first so that it is unregistered after
+ *  the helper mutex is released, since the callback itself takes that
+ *  mutex.
+ *
+ * \return
+ *      Returns the value of predicate(), which may be false if the wait
+ *      ended because of the stop.
+ */
+
+bool
+synchronizer::wait (const stop_token & token)
+{
+    stop_callback wakeup
+    (
+        token, [this] ()
+        {
+            std::lock_guard<std::mutex> locker(m_helper_mutex);
+            m_condition_var.notify_all();
+        }
+    );
+    std::unique_lock<std::mutex> locker(m_helper_mutex);
+    waiter_count counter(m_waiters);
+    auto pred = [&] { return predicate() || token.stop_requested(); };
+    if (m_batch_count > 1 && m_batch_us > 0)
+    {
+        auto step = std::chrono::microseconds(m_batch_us);
+        while (! m_condition_var.wait_for(locker, step, pred))
+        {
+            // keep waiting
+        }
+    }
+    else
+        m_condition_var.wait(locker, pred);
+
     return predicate();
 }
 
+/**
+ *  Like wait(), but gives up after the given time.  A thread that must run
+ *  at least once per period (a watchdog, say) can use this instead of
+ *  polling the predicate with microsleep().
+ *
+ * \param us
+ *      The longest wait, in microseconds.
+ *
+ * \return
+ *      Returns the value of predicate(), which is false if the wait timed
+ *      out without the predicate becoming true.
+ */
+
+bool
+synchronizer::wait_for (int us)
+{
+    return wait_until
+    (
+        std::chrono::steady_clock::now() + std::chrono::microseconds(us)
+    );
+}
+
+/**
+ *  Like wait_for(), but with an absolute deadline, so that a periodic loop
+ *  does not drift by the time spent doing its work.
+ *
+ * \return
+ *      Returns the value of predicate().
+ */
+
+bool
+synchronizer::wait_until (std::chrono::steady_clock::time_point deadline)
+{
+    std::unique_lock<std::mutex> locker(m_helper_mutex);
+    waiter_count counter(m_waiters);
+    return m_condition_var.wait_until
+    (
+        locker, deadline, [this]{ return predicate(); }
+    );
+}
+
+/**
+ *  Wakes one waiter.  With an atomic predicate (see the constructor), if no
+ *  thread is waiting, this is just one atomic load: no lock, no notify, no
+ *  system call.  Otherwise it always locks and notifies.
+ *
+ *  Why the skip is safe:  the waiter increments m_waiters and then, holding
+ *  the mutex, tests predicate(); the signaller changes the predicate's
+ *  state and then loads m_waiters.  If all four operations are sequentially
+ *  consistent (the default for std::atomic), either the signaller sees the
+ *  waiter, and takes the mutex and notifies it, or the waiter sees the new
+ *  state and does not sleep.  So the state that predicate() tests must be
+ *  kept in atomics written with the default memory order, before calling
+ *  signal().
+ *
+ *  When batching (see set_batching()), the notification is held back until
+ *  the batch count is reached, or until the batch time has passed since the
+ *  first held-back signal.
+ */
+
 void
 synchronizer::signal ()
 {
+    if (m_atomic_predicate && m_waiters.load() == 0)
+        return;
+
+    if (m_batch_count > 1)
+    {
+        int pending = m_pending.fetch_add(1, std::memory_order_relaxed);
+        if (pending == 0)
+        {
+            m_pending_since.store
+            (
+                steady_microseconds(), std::memory_order_relaxed
+            );
+            return;
+        }
+        bool full = pending + 1 >= m_batch_count;
+        if (! full)
+        {
+            if (m_batch_us <= 0)
+                return;
+
+            long long since = m_pending_since.load(std::memory_order_relaxed);
+            if (steady_microseconds() - since < m_batch_us)
+                return;
+        }
+        m_pending.store(0, std::memory_order_relaxed);
+    }
     std::lock_guard<std::mutex> locker(m_helper_mutex);
     m_condition_var.notify_one();
 }
 
+/**
+ *  Wakes every waiting thread, for example at shutdown, after setting the
+ *  flag that makes predicate() return true.  Batching does not apply.
+ */
+
+void
+synchronizer::signal_all ()
+{
+    if (m_atomic_predicate && m_waiters.load() == 0)
+        return;
+
+    m_pending.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> locker(m_helper_mutex);
+    m_condition_var.notify_all();
+}
+
+/**
+ *  Passes on any held-back signals now.  A producer that batches should call
+ *  this when it runs out of work.
+ */
+
+void
+synchronizer::flush ()
+{
+    if (m_pending.exchange(0, std::memory_order_relaxed) > 0)
+    {
+        if (! m_atomic_predicate || m_waiters.load() > 0)
+        {
+            std::lock_guard<std::mutex> locker(m_helper_mutex);
+            m_condition_var.notify_one();
+        }
+    }
+}
+
+/**
+ *  Turns on batching of signals.  A waiter is then woken once per "count"
+ *  calls to signal(), or once the first held-back signal is "us"
+ *  microseconds old, whichever comes first.  The age is checked only in
+ *  signal(), but a waiter also wakes by itself every "us" microseconds, so
+ *  no signal is held back much longer than that.  Call this before any
+ *  thread uses the synchronizer.
+ *
+ * \param count
+ *      The batch size.  1 or less turns batching off.
+ *
+ * \param us
+ *      The batch time limit, in microseconds.  0 means no limit; then only
+ *      the count, and flush(), pass on signals.
+ */
+
+void
+synchronizer::set_batching (int count, int us)
+{
+    m_batch_count = count;
+    m_batch_us = us > 0 ? us : 0 ;
+}
+
 }           // namespace xpc
 
 /*
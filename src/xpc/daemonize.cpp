@@ -21,7 +21,7 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2005-07-03 to 2007-08-21 (pre-Sequencer24/64)
- * \updates       2024-02-28
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  Daemonization module of the POSIX C Wrapper (PSXC) library
@@ -86,6 +86,7 @@
 #include "c_macros.h"                   /* errprint()                       */
 #include "platform_macros.h"            /* detects the build platform       */
 #include "xpc/daemonize.hpp"            /* daemonization functions & macros */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_source, stop_token     */
 #include "xpc/utilfunctions.hpp"        /* xpc::file_error() etc.           */
 
 #if defined PLATFORM_UNIX               // PLATFORM_LINUX
@@ -96,6 +97,7 @@
 #include <syslog.h>                     /* syslog() and related constants   */
 #include <unistd.h>                     /* exit(), setsid()                 */
 
+
 #define STD_CLOSE       close
 #define STD_OPEN        open
 #define STD_O_RDWR      O_RDWR
@@ -532,14 +534,20 @@ session_restart ()
     return result;
 }
 
+static void stop_session_callbacks ();
+
 /**
  *  Returns the boolean to indicate a request to close the application.
+ *  If a signal requested it, this also runs the session stop token's
+ *  callbacks, which the signal handler could not run.
  */
 
 bool
 session_close ()
 {
     bool result = sg_needs_close;
+    if (result)
+        stop_session_callbacks();
 
 #if defined PLATFORM_DEBUG_TMI
     if (result)
@@ -572,9 +580,89 @@ void signal_for_save ()
     sg_needs_save = true;
 }
 
+/**
+ *  The source behind session_stop_token().  It is created before the
+ *  signal handler is installed, and the handler reads it through an atomic
+ *  pointer.  A stop cannot be undone, so session_setup() replaces a
+ *  stopped source for a restart.  The old one is never deleted, since a
+ *  signal handler may still be using it; restarts are rare.
+ */
+
+static std::atomic<stop_source *> sg_session_stop_source {};
+
+static stop_source &
+session_stop_source ()
+{
+    stop_source * s = sg_session_stop_source.load();
+    if (s == nullptr)
+    {
+        stop_source * fresh = new stop_source();
+        if (sg_session_stop_source.compare_exchange_strong(s, fresh))
+            s = fresh;
+        else
+            delete fresh;                   /* another thread won the race  */
+    }
+    return *s;
+}
+
+/**
+ *  Gives the session a fresh, unstopped stop source if the current one has
+ *  been stopped.  Any callbacks of the old one that a signal left pending
+ *  are run first.
+ */
+
+static void
+renew_session_stop_source ()
+{
+    stop_source & old = session_stop_source();
+    if (old.stop_requested())
+    {
+        old.run_callbacks();
+        sg_session_stop_source = new stop_source();
+    }
+}
+
+#if defined PLATFORM_LINUX
+
+/**
+ *  The async-signal-safe part of a stop of the session token:  the token
+ *  sleeps and waitable wake now, and the callbacks (such as the wakeups of
+ *  condition::wait(token)) run at the next session_close().  This is Linux
+ *  only, since elsewhere futex_wake_all() falls back to a std::mutex and a
+ *  condition variable, which a signal handler must not touch.
+ */
+
+static void
+stop_session_async ()
+{
+    stop_source * s = sg_session_stop_source.load();
+    if (s != nullptr)
+        (void) s->request_stop_async();
+}
+
+#endif
+
+stop_token
+session_stop_token ()
+{
+    return session_stop_source().get_token();
+}
+
+/**
+ *  Finishes a stop of the session token that a signal started, or, where
+ *  the handler cannot start it (not Linux), does all of it.
+ */
+
+static void
+stop_session_callbacks ()
+{
+    (void) session_stop_source().request_stop();
+}
+
 void signal_for_exit ()
 {
     sg_needs_close = true;
+    (void) session_stop_source().request_stop();
 }
 
 /**
@@ -618,11 +706,17 @@ session_handler (int sig)
     case SIGINT:                        /* 2: Ctrl-C "terminal interrupt"   */
 
         sg_needs_close = true;
+#if defined PLATFORM_LINUX
+        stop_session_async();
+#endif
         break;
 
     case SIGTERM:                       /* 15: "terminate process"          */
 
         sg_needs_close = true;
+#if defined PLATFORM_LINUX
+        stop_session_async();
+#endif
         break;
 
     case SIGUSR1:                       /* 10: "user-defined signal 1       */
@@ -633,7 +727,9 @@ session_handler (int sig)
 }
 
 /**
- *  Sets up the application to intercept SIGINT, SIGTERM, and SIGUSR1.
+ *  Sets up the application to intercept SIGINT, SIGTERM, and SIGUSR1.  Also
+ *  creates the session_stop_token() source, or, on a restart after a stop,
+ *  replaces it with an unstopped one.
  */
 
 void
@@ -643,6 +739,7 @@ session_setup ()
     std::memset(&action, 0, sizeof action);
     action.sa_handler = session_handler;
     sg_needs_close = sg_needs_save = sg_restart = false;
+    renew_session_stop_source();
     sigaction(SIGINT, &action, NULL);                   /* SIGINT is 2      */
     sigaction(SIGTERM, &action, NULL);                  /* SIGTERM is 15    */
     sigaction(SIGUSR1, &action, NULL);                  /* SIGUSR1 is 10    */
@@ -0,0 +1,422 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          fastclock.cpp
+ *
+ *  This module defines the TSC-based fast clock.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Calibration.  A (TSC, nanotime) pair is sampled by reading the TSC on
+ *  both sides of nanotime(), keeping the tightest of a few tries, and
+ *  using the midpoint.  The initial rate comes from two pairs 10 ms apart.
+ *  Each recalibration measures the rate over the whole time since
+ *  fastclock_init(), so it gets more accurate as the program runs.
+ *
+ *  Continuity.  A recalibration starts the new segment where the old one
+ *  would have been at that moment, and sets the new multiplier to absorb
+ *  the measured error over the next interval.  Only a large forward error
+ *  (e.g. after a suspend) is stepped.  That is continuous only at the
+ *  moment of the recalibration: a reader still using the old parameters
+ *  a little later, or one whose TSC read on another core is slightly
+ *  behind, can be ahead of the new segment when the new one runs slower.
+ *  So fastclock_ns() clamps to the last value returned in the calling
+ *  thread.  A process-wide atomic maximum would also order the threads,
+ *  but it would bounce one cache line between every core taking
+ *  timestamps, which is what this clock is meant to avoid.
+ *
+ *  The scaling needs a 64 x 64 -> 128 bit multiply, so the TSC is used
+ *  only on x86-64 with GCC or Clang.
+ */
+
+#include <mutex>                        /* std::mutex, std::unique_lock<>   */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/fastclock.hpp"            /* xpc::fastclock_ns(), etc.        */
+#include "xpc/seqlock.hpp"              /* xpc::seqlock<>                   */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), millisleep()    */
+
+#if defined __x86_64__ && (defined __GNUC__ || defined __clang__)
+#define XPC66_FASTCLOCK_TSC
+#include <cpuid.h>                      /* __get_cpuid()                    */
+#include <x86intrin.h>                  /* __rdtsc()                        */
+#endif
+
+#if defined PLATFORM_LINUX
+#include <cstdio>                       /* std::fopen(), std::fgets()       */
+#include <cstring>                      /* std::strstr()                    */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+namespace
+{
+
+/**
+ *  The parameters published to the readers.
+ */
+
+struct fastclock_params
+{
+    std::uint64_t tsc_base;             /* TSC at the start of the segment  */
+    std::int64_t ns_base;               /* nanotime at the same moment      */
+    std::uint64_t mult;                 /* ns per tick, << c_shift          */
+    std::uint64_t tsc_due;              /* recalibrate after this TSC       */
+    int active;                         /* 0 means "use nanotime()"         */
+};
+
+const int c_shift = 32;
+
+/**
+ *  Forward errors bigger than this are stepped, not slewed.
+ */
+
+const std::int64_t c_step_ns = 1000000;
+
+seqlock<fastclock_params> s_params;
+
+/**
+ *  Calibration state, used only under s_cal_mutex.
+ */
+
+std::mutex s_cal_mutex;
+std::uint64_t s_ref_tsc = 0;
+std::int64_t s_ref_ns = 0;
+std::uint64_t s_interval_tsc = 0;
+std::int64_t s_tsc_hz = 0;
+
+/**
+ *  The last value fastclock_ns() returned in this thread.
+ */
+
+thread_local std::int64_t tl_last_ns = 0;
+
+/**
+ *  Returns the larger of a reading and the last one returned in this
+ *  thread, and remembers it.
+ */
+
+inline std::int64_t
+not_before_last (std::int64_t ns)
+{
+    if (ns < tl_last_ns)
+        return tl_last_ns;
+
+    tl_last_ns = ns;
+    return ns;
+}
+
+#if defined XPC66_FASTCLOCK_TSC
+
+__extension__ typedef unsigned __int128 wide;
+__extension__ typedef __int128 signed_wide;
+
+inline std::uint64_t
+read_tsc ()
+{
+    return __rdtsc();
+}
+
+/**
+ *  Samples the TSC and nanotime() at (nearly) the same instant.
+ */
+
+void
+sample_pair (std::uint64_t & tsc, std::int64_t & ns)
+{
+    std::uint64_t best = ~std::uint64_t(0);
+    tsc = read_tsc();
+    ns = nanotime();
+    for (int i = 0; i < 5; ++i)
+    {
+        std::uint64_t a = read_tsc();
+        std::int64_t n = nanotime();
+        std::uint64_t b = read_tsc();
+        if (b - a < best)
+        {
+            best = b - a;
+            tsc = a + (b - a) / 2;
+            ns = n;
+        }
+    }
+}
+
+/**
+ *  Converts a TSC value with the given parameters.  A TSC slightly behind
+ *  the base (a read on another core, just after a recalibration) is
+ *  clamped to the base.
+ */
+
+inline std::int64_t
+convert (const fastclock_params & p, std::uint64_t tsc)
+{
+    std::uint64_t delta = tsc > p.tsc_base ? tsc - p.tsc_base : 0 ;
+    return p.ns_base + std::int64_t((wide(delta) * p.mult) >> c_shift);
+}
+
+/**
+ *  The rate, in ns per tick << c_shift, between two samples.
+ */
+
+std::uint64_t
+rate_mult (std::uint64_t dtsc, std::int64_t dns)
+{
+    if (dtsc == 0 || dns <= 0)
+        return 0;
+
+    return std::uint64_t((wide(dns) << c_shift) / dtsc);
+}
+
+/**
+ *  Starts a new segment.  Called with s_cal_mutex held.
+ *
+ * \param forced
+ *      If false, nothing is done unless the recalibration is due; another
+ *      thread may have just done it.
+ */
+
+void
+recalibrate_locked (bool forced)
+{
+    fastclock_params p = s_params.load();
+    if (p.active == 0)
+        return;
+
+    std::uint64_t tsc = 0;
+    std::int64_t ns = 0;
+    sample_pair(tsc, ns);
+    if (! forced && tsc < p.tsc_due)
+        return;
+
+    std::int64_t fast = convert(p, tsc);
+    std::int64_t error = ns - fast;
+    std::uint64_t rate = rate_mult(tsc - s_ref_tsc, ns - s_ref_ns);
+    if (rate == 0)
+        return;
+
+    fastclock_params next = p;
+    next.tsc_base = tsc;
+    next.tsc_due = tsc + s_interval_tsc;
+    if (error > c_step_ns)
+    {
+        next.ns_base = ns;                      /* jump forward             */
+        next.mult = rate;
+        s_ref_tsc = tsc;
+        s_ref_ns = ns;
+    }
+    else
+    {
+        /*
+         * Run fast or slow enough to absorb the error by the next
+         * recalibration, but never slower than half speed.
+         */
+
+        next.ns_base = fast;
+        signed_wide adjust =
+            (signed_wide(error) << c_shift) / signed_wide(s_interval_tsc);
+
+        signed_wide m = signed_wide(rate) + adjust;
+        if (m < signed_wide(rate / 2))
+            m = rate / 2;
+
+        next.mult = std::uint64_t(m);
+    }
+    s_params.store(next);
+}
+
+#endif      // XPC66_FASTCLOCK_TSC
+
+}           // anonymous namespace
+
+/**
+ *  Tells if the processor has a TSC this module can trust: it must be
+ *  invariant (CPUID leaf 0x80000007, EDX bit 8), and, in Linux, still be
+ *  on the kernel's list of clock sources (the kernel drops it there if it
+ *  finds it unstable, e.g. unsynchronized between sockets).
+ */
+
+bool
+fastclock_supported ()
+{
+#if defined XPC66_FASTCLOCK_TSC
+    unsigned eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0)
+        return false;
+
+    if (eax < 0x80000007)
+        return false;
+
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0)
+        return false;
+
+    if ((edx & (1u << 8)) == 0)
+        return false;
+
+#if defined PLATFORM_LINUX
+    std::FILE * f = std::fopen
+    (
+        "/sys/devices/system/clocksource/clocksource0/available_clocksource",
+        "r"
+    );
+    if (f != NULL)
+    {
+        char line[256];
+        bool listed = std::fgets(line, sizeof line, f) != NULL &&
+            std::strstr(line, "tsc") != NULL;
+
+        std::fclose(f);
+        if (! listed)
+            return false;
+    }
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ *  Turns the fast clock on (after checking and calibrating the TSC, which
+ *  takes about 10 ms), or off.  Call it once at startup, before the
+ *  threads that take timestamps start.
+ *
+ * \param enable
+ *      If false, fastclock_ns() goes back to calling nanotime().
+ *
+ * \return
+ *      Returns true if the TSC is now in use.
+ */
+
+bool
+fastclock_init (bool enable)
+{
+    std::unique_lock<std::mutex> guard(s_cal_mutex);
+    fastclock_params p = fastclock_params();
+    if (! enable || ! fastclock_supported())
+    {
+        s_params.store(p);
+        return false;
+    }
+#if defined XPC66_FASTCLOCK_TSC
+    std::uint64_t t0 = 0, t1 = 0;
+    std::int64_t n0 = 0, n1 = 0;
+    sample_pair(t0, n0);
+    (void) millisleep(10);
+    sample_pair(t1, n1);
+
+    std::uint64_t rate = rate_mult(t1 - t0, n1 - n0);
+    if (rate == 0)
+    {
+        s_params.store(p);
+        return false;
+    }
+    s_ref_tsc = t0;
+    s_ref_ns = n0;
+    s_tsc_hz = std::int64_t((wide(t1 - t0) * 1000000000u) / wide(n1 - n0));
+    s_interval_tsc = std::uint64_t(s_tsc_hz);           /* about 1 second   */
+    p.tsc_base = t1;
+    p.ns_base = n1;
+    p.mult = rate;
+    p.tsc_due = t1 + s_interval_tsc;
+    p.active = 1;
+    s_params.store(p);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+fastclock_active ()
+{
+    return s_params.load().active != 0;
+}
+
+/**
+ *  Forces a recalibration now.  Normally not needed, since fastclock_ns()
+ *  recalibrates about once a second.
+ */
+
+void
+fastclock_recalibrate ()
+{
+#if defined XPC66_FASTCLOCK_TSC
+    std::unique_lock<std::mutex> guard(s_cal_mutex);
+    recalibrate_locked(true);
+#endif
+}
+
+/**
+ *  The TSC frequency found by fastclock_init(), or 0.
+ */
+
+std::int64_t
+fastclock_tsc_hz ()
+{
+    std::unique_lock<std::mutex> guard(s_cal_mutex);
+    return s_tsc_hz;
+}
+
+/**
+ *  Gets the time in nanoseconds, on the nanotime() scale.  When a
+ *  recalibration is due, the first caller to notice does it (the others
+ *  do not wait for it).  A value is never less than the last one returned
+ *  in the calling thread, even across a recalibration or a call to
+ *  fastclock_init().
+ */
+
+std::int64_t
+fastclock_ns ()
+{
+#if defined XPC66_FASTCLOCK_TSC
+    fastclock_params p = s_params.load();
+    if (p.active != 0)
+    {
+        std::uint64_t tsc = read_tsc();
+        if (tsc >= p.tsc_due)
+        {
+            std::unique_lock<std::mutex> guard
+            (
+                s_cal_mutex, std::try_to_lock
+            );
+            if (guard.owns_lock())
+                recalibrate_locked(false);
+        }
+        return not_before_last(convert(p, tsc));
+    }
+#endif
+    return not_before_last(nanotime());
+}
+
+}           // namespace xpc
+
+/*
+ * fastclock.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
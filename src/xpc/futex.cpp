@@ -0,0 +1,208 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          futex.cpp
+ *
+ *  This module defines the "wait on an address" helpers.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  The Linux futex(2) call has no glibc wrapper, so we use syscall().  A
+ *  relative timeout for FUTEX_WAIT is measured on CLOCK_MONOTONIC.
+ */
+
+#include <climits>                      /* INT_MAX                          */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/futex.hpp"                /* xpc::futex_wait(), futex_wake()  */
+
+#if defined PLATFORM_LINUX
+#include <cerrno>                       /* errno, ETIMEDOUT                 */
+#include <ctime>                        /* struct timespec                  */
+#include <linux/futex.h>                /* FUTEX_WAIT_PRIVATE, etc.         */
+#include <sys/syscall.h>                /* SYS_futex                        */
+#include <unistd.h>                     /* syscall()                        */
+#else
+#include <chrono>                       /* std::chrono::nanoseconds         */
+#include <condition_variable>           /* std::condition_variable          */
+#include <cstdint>                      /* std::uintptr_t                   */
+#include <mutex>                        /* std::mutex, std::unique_lock<>   */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+static_assert
+(
+    sizeof(std::atomic<int>) == sizeof(int),
+    "std::atomic<int> must be a plain int to be used as a futex word"
+);
+
+#if defined PLATFORM_LINUX
+
+namespace
+{
+
+long
+sys_futex (std::atomic<int> & word, int op, int value, const timespec * ts)
+{
+    return syscall
+    (
+        SYS_futex, reinterpret_cast<int *>(&word), op, value, ts, nullptr, 0
+    );
+}
+
+}           // anonymous namespace
+
+/**
+ *  Sleeps while the word holds the expected value.
+ *
+ * \param word
+ *      The atomic word to wait on.
+ *
+ * \param expected
+ *      The value meaning "keep waiting".  If the word differs, the call
+ *      returns at once.
+ *
+ * \param timeout_ns
+ *      The longest wait, in nanoseconds.  Negative means no limit.
+ *
+ * \return
+ *      Returns false if the wait timed out.  Otherwise it returns true,
+ *      which means the word changed, or a wake was issued, or the wakeup was
+ *      spurious (a signal, say).  Callers re-check the word in a loop.
+ */
+
+bool
+futex_wait (std::atomic<int> & word, int expected, long long timeout_ns)
+{
+    timespec ts;
+    timespec * tsp = nullptr;
+    if (timeout_ns >= 0)
+    {
+        ts.tv_sec = time_t(timeout_ns / 1000000000LL);
+        ts.tv_nsec = long(timeout_ns % 1000000000LL);
+        tsp = &ts;
+    }
+    long rc = sys_futex(word, FUTEX_WAIT_PRIVATE, expected, tsp);
+    return ! (rc == -1 && errno == ETIMEDOUT);
+}
+
+/**
+ *  Wakes up to "count" threads sleeping in futex_wait() on the word.  This
+ *  is a system call, so callers make it only when they know (or fear) that
+ *  a thread is asleep.
+ */
+
+void
+futex_wake (std::atomic<int> & word, int count)
+{
+    (void) sys_futex(word, FUTEX_WAKE_PRIVATE, count, nullptr);
+}
+
+void
+futex_wake_all (std::atomic<int> & word)
+{
+    (void) sys_futex(word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+}
+
+#else       // ! defined PLATFORM_LINUX
+
+namespace
+{
+
+/**
+ *  One of the stand-in wait queues.  A wake notifies all of the threads in
+ *  the bucket, since they may be waiting on different words.
+ */
+
+struct bucket
+{
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
+const std::size_t c_bucket_count = 64;
+
+bucket &
+bucket_for (const std::atomic<int> & word)
+{
+    static bucket s_buckets[c_bucket_count];
+    std::uintptr_t a = reinterpret_cast<std::uintptr_t>(&word);
+    return s_buckets[(a >> 4) % c_bucket_count];
+}
+
+}           // anonymous namespace
+
+bool
+futex_wait (std::atomic<int> & word, int expected, long long timeout_ns)
+{
+    bucket & b = bucket_for(word);
+    std::unique_lock<std::mutex> locker(b.m_mutex);
+    if (word.load() != expected)
+        return true;
+
+    if (timeout_ns < 0)
+    {
+        b.m_condition.wait(locker);
+        return true;
+    }
+    auto rc = b.m_condition.wait_for
+    (
+        locker, std::chrono::nanoseconds(timeout_ns)
+    );
+    return rc == std::cv_status::no_timeout;
+}
+
+/**
+ *  Taking the bucket's mutex orders this wake after any waiter's check of
+ *  the word, so a waiter that saw the old value is already asleep.
+ */
+
+void
+futex_wake (std::atomic<int> & word, int /* count */)
+{
+    bucket & b = bucket_for(word);
+    std::lock_guard<std::mutex> locker(b.m_mutex);
+    b.m_condition.notify_all();
+}
+
+void
+futex_wake_all (std::atomic<int> & word)
+{
+    futex_wake(word, INT_MAX);
+}
+
+#endif      // defined PLATFORM_LINUX
+
+}           // namespace xpc
+
+/*
+ * futex.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,410 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          lockorder.cpp
+ *
+ *  This module defines the debug-build lock-order checker.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  See lockorder.hpp for the description.  The graph is guarded by a plain
+ *  std::mutex, never by a recmutex, so that the checker does not check
+ *  itself.  All of the state is in function-local statics, since recmutexes
+ *  can be locked during static initialization.  The shared state is
+ *  allocated and never freed: it is first used at the first nested
+ *  locking, after static recmutexes have been built, so as an ordinary
+ *  static it would be destroyed before them, and their destructors would
+ *  then call lock_order_forget() on a destroyed graph.
+ *
+ *  Stack traces use the glibc backtrace() functions.  Elsewhere the reports
+ *  carry only the mutex names.  Link with "-rdynamic" to get function names
+ *  rather than bare addresses in the traces.
+ */
+
+#include "xpc/lockorder.hpp"            /* XPC66_LOCK_ORDER_CHECK, hooks    */
+
+#if defined XPC66_LOCK_ORDER_CHECK
+
+#include <algorithm>                    /* std::min(), std::max()           */
+#include <atomic>                       /* std::atomic<int>                 */
+#include <cstdio>                       /* std::fprintf()                   */
+#include <iterator>                     /* std::next()                      */
+#include <map>                          /* std::map<>                       */
+#include <mutex>                        /* std::mutex, std::lock_guard<>    */
+#include <set>                          /* std::set<>                       */
+#include <string>                       /* std::string                      */
+#include <utility>                      /* std::pair<>                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/recmutex.hpp"             /* xpc::recmutex::name()            */
+
+#if defined PLATFORM_LINUX && defined __GLIBC__
+#include <execinfo.h>                   /* backtrace(), backtrace_symbols_fd*/
+#include <unistd.h>                     /* STDERR_FILENO                    */
+#define XPC66_HAVE_BACKTRACE
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/*
+ *  Internal types and state.
+ */
+
+namespace
+{
+
+using stack_trace = std::vector<void *>;
+
+/**
+ *  Deep enough to get out of the locking code and into the caller's.
+ */
+
+const int c_max_frames = 24;
+
+/**
+ *  A mutex that has been seen in nested locking, and the mutexes that have
+ *  been acquired while holding it.  Each such edge remembers the stack of
+ *  the first acquisition in that order.
+ */
+
+struct lock_node
+{
+    std::string name;
+    std::map<const recmutex *, stack_trace> after;
+};
+
+using lock_graph = std::map<const recmutex *, lock_node>;
+using lock_pair = std::pair<const recmutex *, const recmutex *>;
+
+/**
+ *  A mutex held by the current thread, with its recursion count.
+ */
+
+struct held_lock
+{
+    const recmutex * mutex;
+    int count;
+};
+
+std::mutex &
+graph_mutex ()
+{
+    static std::mutex * s_graph_mutex = new std::mutex;
+    return *s_graph_mutex;
+}
+
+lock_graph &
+graph ()
+{
+    static lock_graph * s_graph = new lock_graph;
+    return *s_graph;
+}
+
+std::set<lock_pair> &
+reported_pairs ()
+{
+    static std::set<lock_pair> * s_reported = new std::set<lock_pair>;
+    return *s_reported;
+}
+
+std::atomic<int> s_violations { 0 };
+
+std::vector<held_lock> &
+held_locks ()
+{
+    static thread_local std::vector<held_lock> t_held;
+    return t_held;
+}
+
+std::string
+mutex_name (const recmutex * m)
+{
+    const char * n = m->name();
+    if (n != nullptr && n[0] != 0)
+        return std::string(n);
+
+    char temp[32];
+    std::snprintf
+    (
+        temp, sizeof temp, "recmutex@%p", static_cast<const void *>(m)
+    );
+    return std::string(temp);
+}
+
+stack_trace
+capture_stack ()
+{
+    stack_trace result;
+#if defined XPC66_HAVE_BACKTRACE
+    result.resize(c_max_frames);
+    int count = backtrace(result.data(), c_max_frames);
+    result.resize(count > 0 ? std::size_t(count) : 0);
+#endif
+    return result;
+}
+
+void
+print_stack (const char * tag, const stack_trace & trace)
+{
+    std::fprintf(stderr, "  %s:\n", tag);
+#if defined XPC66_HAVE_BACKTRACE
+    if (! trace.empty())
+    {
+        std::fflush(stderr);
+        backtrace_symbols_fd
+        (
+            const_cast<void * const *>(trace.data()), int(trace.size()),
+            STDERR_FILENO
+        );
+        return;
+    }
+#endif
+    std::fprintf(stderr, "    (no stack trace available)\n");
+}
+
+lock_node &
+node_for (lock_graph & g, const recmutex * m)
+{
+    auto it = g.find(m);
+    if (it == g.end())
+    {
+        lock_node n;
+        n.name = mutex_name(m);
+        it = g.emplace(m, n).first;
+    }
+    return it->second;
+}
+
+/**
+ *  Depth-first search for a path from "from" to "to".  On success, the path
+ *  holds the mutexes visited, starting with "from" and ending with "to".
+ */
+
+bool
+find_path
+(
+    const lock_graph & g,
+    const recmutex * from,
+    const recmutex * to,
+    std::set<const recmutex *> & visited,
+    std::vector<const recmutex *> & path
+)
+{
+    path.push_back(from);
+    if (from == to)
+        return true;
+
+    if (visited.insert(from).second)
+    {
+        auto it = g.find(from);
+        if (it != g.end())
+        {
+            for (const auto & e : it->second.after)
+            {
+                if (find_path(g, e.first, to, visited, path))
+                    return true;
+            }
+        }
+    }
+    path.pop_back();
+    return false;
+}
+
+/**
+ *  Reports acquiring "next" while holding "held", when the graph already
+ *  has the path "next" -> ... -> "held".  Called with the graph locked.
+ */
+
+void
+report_inversion
+(
+    const lock_graph & g,
+    const recmutex * held,
+    const recmutex * next,
+    const std::vector<const recmutex *> & path
+)
+{
+    std::string order;
+    for (auto m : path)
+    {
+        if (! order.empty())
+            order += " -> ";
+
+        order += g.at(m).name;
+    }
+    std::fprintf
+    (
+        stderr,
+        "[xpc66] lock-order inversion: acquiring '%s' while holding '%s'\n"
+        "  established order: %s\n",
+        g.at(next).name.c_str(), g.at(held).name.c_str(), order.c_str()
+    );
+    print_stack("current stack", capture_stack());
+    if (path.size() >= 2)
+    {
+        const auto & first = g.at(path[0]).after.at(path[1]);
+        std::string tag = "stack where '" + g.at(path[0]).name +
+            "' -> '" + g.at(path[1]).name + "' was first seen";
+
+        print_stack(tag.c_str(), first);
+    }
+    std::fflush(stderr);
+}
+
+}           // anonymous namespace
+
+/**
+ *  Called by recmutex::lock() before it blocks.  A recursive acquisition of
+ *  a mutex already held by this thread just bumps its count.  Otherwise,
+ *  every mutex held by this thread gets an edge to the new one, checking
+ *  for a cycle the first time each edge appears.
+ */
+
+void
+lock_order_acquire (const recmutex * m)
+{
+    auto & held = held_locks();
+    for (auto & h : held)
+    {
+        if (h.mutex == m)
+        {
+            ++h.count;
+            return;
+        }
+    }
+    if (! held.empty())
+    {
+        std::lock_guard<std::mutex> guard(graph_mutex());
+        lock_graph & g = graph();
+        for (const auto & h : held)
+        {
+            lock_node & before = node_for(g, h.mutex);
+            if (before.after.count(m) > 0)
+                continue;                       /* known edge, known good   */
+
+            (void) node_for(g, m);
+            std::set<const recmutex *> visited;
+            std::vector<const recmutex *> path;
+            if (find_path(g, m, h.mutex, visited, path))
+            {
+                lock_pair key{ std::min(m, h.mutex), std::max(m, h.mutex) };
+                if (reported_pairs().insert(key).second)
+                {
+                    ++s_violations;
+                    report_inversion(g, h.mutex, m, path);
+                }
+            }
+            g[h.mutex].after.emplace(m, capture_stack());
+        }
+    }
+    held.push_back(held_lock{ m, 1 });
+}
+
+/**
+ *  Called by recmutex::unlock().  Mutexes need not be released in reverse
+ *  order, so we search from the most recent.
+ */
+
+void
+lock_order_release (const recmutex * m)
+{
+    auto & held = held_locks();
+    for (auto it = held.rbegin(); it != held.rend(); ++it)
+    {
+        if (it->mutex == m)
+        {
+            if (--it->count == 0)
+                held.erase(std::next(it).base());
+
+            return;
+        }
+    }
+}
+
+/**
+ *  Called when a recmutex is destroyed, since its address may be reused by
+ *  an unrelated mutex.  A mutex that never took part in nested locking has
+ *  no node, and no edges point to it.
+ */
+
+void
+lock_order_forget (const recmutex * m)
+{
+    std::lock_guard<std::mutex> guard(graph_mutex());
+    lock_graph & g = graph();
+    auto it = g.find(m);
+    if (it != g.end())
+    {
+        g.erase(it);
+        for (auto & n : g)
+            n.second.after.erase(m);
+
+        auto & pairs = reported_pairs();
+        for (auto p = pairs.begin(); p != pairs.end(); /* in body */)
+        {
+            if (p->first == m || p->second == m)
+                p = pairs.erase(p);
+            else
+                ++p;
+        }
+    }
+}
+
+/**
+ *  The number of distinct inversions reported so far.
+ */
+
+int
+lock_order_violations ()
+{
+    return s_violations;
+}
+
+/**
+ *  Clears the graph and the count.  Locks currently held are still
+ *  tracked.
+ */
+
+void
+lock_order_reset ()
+{
+    std::lock_guard<std::mutex> guard(graph_mutex());
+    graph().clear();
+    reported_pairs().clear();
+    s_violations = 0;
+}
+
+}           // namespace xpc
+
+#endif      // defined XPC66_LOCK_ORDER_CHECK
+
+/*
+ * lockorder.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
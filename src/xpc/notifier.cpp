@@ -0,0 +1,235 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          notifier.cpp
+ *
+ *  This module defines the pollable notifier.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Coalescing:  signal() sets m_pending and writes only if it was clear.
+ *  drain() empties the descriptor and only then clears m_pending, with an
+ *  exchange (acquire) that pairs with signal()'s exchange (release).  So a
+ *  signal() that skipped its write, because m_pending was still set, made
+ *  its data visible to the consumer, who looks for work after drain().  A
+ *  signal() after the clearing writes again.
+ *
+ *  write() and read() of an eventfd are async-signal-safe, so signal() may
+ *  be called from a signal handler.
+ */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX, PLATFORM_UNIX    */
+#include "xpc/notifier.hpp"             /* xpc::notifier                    */
+#include "xpc/utilfunctions.hpp"        /* xpc::error_message()             */
+
+#if defined PLATFORM_UNIX
+#include <cerrno>                       /* errno, EINTR                     */
+#include <cstdint>                      /* std::uint64_t                    */
+#include <fcntl.h>                      /* fcntl(), O_NONBLOCK, FD_CLOEXEC  */
+#include <unistd.h>                     /* read(), write(), close(), pipe() */
+#endif
+
+#if defined PLATFORM_LINUX
+#include <sys/eventfd.h>                /* eventfd(), EFD_NONBLOCK          */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+#if defined PLATFORM_UNIX
+
+namespace
+{
+
+#if ! defined PLATFORM_LINUX
+
+bool
+set_nonblocking (int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return false;
+
+    return fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+#endif
+
+}           // anonymous namespace
+
+/**
+ *  Creates the descriptor(s).  On failure, which only happens when the
+ *  process is out of descriptors, an error is shown and valid() is false.
+ */
+
+notifier::notifier () :
+    m_read_fd       (-1),
+    m_write_fd      (-1),
+    m_pending       (false)
+{
+#if defined PLATFORM_LINUX
+    m_read_fd = m_write_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_read_fd < 0)
+        (void) error_message("notifier", "eventfd() failed");
+#else
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        if (set_nonblocking(fds[0]) && set_nonblocking(fds[1]))
+        {
+            m_read_fd = fds[0];
+            m_write_fd = fds[1];
+        }
+        else
+        {
+            (void) close(fds[0]);
+            (void) close(fds[1]);
+        }
+    }
+    if (m_read_fd < 0)
+        (void) error_message("notifier", "pipe() failed");
+#endif
+}
+
+notifier::~notifier ()
+{
+    if (m_write_fd >= 0 && m_write_fd != m_read_fd)
+        (void) close(m_write_fd);
+
+    if (m_read_fd >= 0)
+        (void) close(m_read_fd);
+}
+
+/**
+ *  Makes the descriptor readable, unless it already is.  If the write fails
+ *  because the eventfd counter or the pipe is full, the descriptor is
+ *  readable anyway, which is all we want.
+ */
+
+void
+notifier::signal ()
+{
+    if (m_pending.exchange(true, std::memory_order_acq_rel))
+        return;
+
+#if defined PLATFORM_LINUX
+    std::uint64_t one = 1;
+    const void * data = &one;
+    std::size_t size = sizeof one;
+#else
+    char one = 1;
+    const void * data = &one;
+    std::size_t size = sizeof one;
+#endif
+    for (;;)
+    {
+        ssize_t rc = write(m_write_fd, data, size);
+        if (rc >= 0 || errno != EINTR)
+            break;
+    }
+}
+
+/**
+ *  Makes the descriptor unreadable again.
+ *
+ * \return
+ *      Returns true if there was a signal to consume.
+ */
+
+bool
+notifier::drain ()
+{
+    bool result = false;
+#if defined PLATFORM_LINUX
+    std::uint64_t count = 0;
+    for (;;)
+    {
+        ssize_t rc = read(m_read_fd, &count, sizeof count);
+        if (rc == ssize_t(sizeof count))
+            result = true;
+        else if (rc < 0 && errno == EINTR)
+            continue;
+
+        break;
+    }
+#else
+    char buffer[64];
+    for (;;)
+    {
+        ssize_t rc = read(m_read_fd, buffer, sizeof buffer);
+        if (rc > 0)
+            result = true;
+        else if (rc < 0 && errno == EINTR)
+            continue;
+        else
+            break;
+    }
+#endif
+    (void) m_pending.exchange(false, std::memory_order_acq_rel);
+    return result;
+}
+
+#else       // ! defined PLATFORM_UNIX
+
+/*
+ *  Not supported:  the notifier is never valid, and never ready.
+ */
+
+notifier::notifier () :
+    m_read_fd       (-1),
+    m_write_fd      (-1),
+    m_pending       (false)
+{
+    (void) error_message("notifier", "not supported on this platform");
+}
+
+notifier::~notifier ()
+{
+    // no code
+}
+
+void
+notifier::signal ()
+{
+    m_pending = true;
+}
+
+bool
+notifier::drain ()
+{
+    return m_pending.exchange(false);
+}
+
+#endif      // defined PLATFORM_UNIX
+
+}           // namespace xpc
+
+/*
+ * notifier.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
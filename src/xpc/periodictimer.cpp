@@ -0,0 +1,150 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          periodictimer.cpp
+ *
+ *  This module defines the periodic_timer class.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Deadlines are kept as 64-bit nanotime() counts and advanced by integer
+ *  addition, so no rounding error accumulates either.  Where there is no
+ *  clock_nanosleep() (macOS, Windows), std::this_thread::sleep_until() on
+ *  the steady clock stands in (see sleep_until_ns()); it is also absolute,
+ *  just coarser.
+ */
+
+#include "xpc/periodictimer.hpp"        /* xpc::periodic_timer              */
+#include "xpc/timing.hpp"               /* xpc::sleep_until_ns(), etc.      */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ * \param period_us
+ *      The period in microseconds.  Values below 1 are made 1.
+ */
+
+periodic_timer::periodic_timer (int period_us) :
+    m_period_ns     (std::int64_t(period_us > 0 ? period_us : 1) * 1000),
+    m_next_ns       (0),
+    m_ticks         (0),
+    m_overruns      (0),
+    m_missed        (0),
+    m_lateness_ns   (0),
+    m_precise       (false)
+{
+    // no code
+}
+
+/**
+ *  Makes the first deadline one period from now, and clears the counters.
+ */
+
+void
+periodic_timer::start ()
+{
+    m_next_ns = nanotime() + m_period_ns;
+    m_ticks = m_overruns = m_missed = m_lateness_ns = 0;
+}
+
+/**
+ *  Sleeps until the next deadline, then moves the deadline on by one
+ *  period.  If the deadline has already passed, this does not sleep; it
+ *  counts an overrun, and skips the deadlines that are entirely in the
+ *  past, so that the next one is still in phase with the start.
+ *
+ * \return
+ *      Returns the number of deadlines skipped, normally 0.
+ */
+
+int
+periodic_timer::wait ()
+{
+    if (m_next_ns == 0)
+        start();
+
+    int skipped = 0;
+    std::int64_t now = nanotime();
+    if (now >= m_next_ns)
+    {
+        std::int64_t behind = (now - m_next_ns) / m_period_ns;
+        ++m_overruns;
+        m_missed += behind;
+        m_next_ns += behind * m_period_ns;
+        skipped = int(behind);
+    }
+    else
+    {
+        if (m_precise)
+            (void) precise_sleep_until_ns(m_next_ns);
+        else
+            sleep_until_ns(m_next_ns);
+
+        now = nanotime();
+    }
+    m_lateness_ns = now - m_next_ns;
+    m_next_ns += m_period_ns;
+    ++m_ticks;
+    return skipped;
+}
+
+/**
+ *  Changes the period without losing phase.  The deadline just reached
+ *  stays the reference point, and the next one is a new period after it.
+ *  Use it for tempo changes.
+ */
+
+void
+periodic_timer::set_period (int period_us)
+{
+    std::int64_t p = std::int64_t(period_us > 0 ? period_us : 1) * 1000;
+    if (m_next_ns != 0)
+        m_next_ns += p - m_period_ns;
+
+    m_period_ns = p;
+}
+
+/**
+ *  Drops the phase, making the next deadline one period from now.  Use it
+ *  after a deliberate pause, so that the pause is not counted as missed
+ *  ticks.  The counters are kept.
+ */
+
+void
+periodic_timer::resync ()
+{
+    m_next_ns = nanotime() + m_period_ns;
+}
+
+}           // namespace xpc
+
+/*
+ * periodictimer.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
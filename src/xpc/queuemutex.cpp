@@ -0,0 +1,235 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          queuemutex.cpp
+ *
+ *  This module defines the MCS queue lock.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  Memory ordering, briefly:
+ *
+ *      -   lock() swaps its node into m_tail (acq_rel): acquire pairs with
+ *          the release of an uncontended unlock(), release publishes the
+ *          node's initialization to the predecessor.
+ *      -   The predecessor hands off by storing false into the waiter's
+ *          flag (release), which the waiter reads with acquire.
+ *
+ *  The queue nodes come from a per-thread pool, tracked by a bit mask, so
+ *  that locks need not be released in reverse order of acquisition.
+ */
+
+#include <cstdlib>                      /* std::abort()                     */
+#include <thread>                       /* std::this_thread::yield()        */
+
+#include "xpc/queuemutex.hpp"           /* xpc::queuemutex                  */
+#include "xpc/utilfunctions.hpp"        /* xpc::error_message()             */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/*
+ *  Per-thread node pool.
+ */
+
+namespace
+{
+
+using qnode = queuemutex::qnode;
+
+thread_local qnode t_nodes[queuemutex::c_max_nested];
+thread_local unsigned t_used_nodes = 0;
+
+/**
+ *  Gets a free node for this thread.  Running out means a thread holds more
+ *  than c_max_nested queuemutexes, which is a design error, not a runtime
+ *  condition we can recover from.
+ */
+
+qnode *
+acquire_node ()
+{
+    for (int i = 0; i < queuemutex::c_max_nested; ++i)
+    {
+        unsigned bit = 1u << i;
+        if ((t_used_nodes & bit) == 0)
+        {
+            t_used_nodes |= bit;
+            return &t_nodes[i];
+        }
+    }
+    (void) error_message("queuemutex", "too many nested locks in one thread");
+    std::abort();
+}
+
+void
+release_node (qnode * n)
+{
+    unsigned index = unsigned(n - &t_nodes[0]);
+    t_used_nodes &= ~(1u << index);
+}
+
+/**
+ *  Spin-wait pacing: pause for a while, then yield now and then, so that a
+ *  waiter does not hog a core needed by the thread it waits for.
+ */
+
+class backoff
+{
+
+private:
+
+    int m_spins = 0;
+
+public:
+
+    void pause ()
+    {
+        if (++m_spins < queuemutex::c_spin_limit)
+        {
+            cpu_relax();
+        }
+        else
+        {
+            m_spins = 0;
+            std::this_thread::yield();
+        }
+    }
+
+};
+
+}           // anonymous namespace
+
+queuemutex::queuemutex () :
+    m_tail          (nullptr),
+    m_owner_node    (nullptr)
+{
+    // no code
+}
+
+/**
+ *  Joins the queue, and waits (on our own node) until the predecessor hands
+ *  the lock to us.  If the queue was empty, we have the lock at once.
+ */
+
+void
+queuemutex::lock ()
+{
+    qnode * n = acquire_node();
+    n->next.store(nullptr, std::memory_order_relaxed);
+    n->locked.store(true, std::memory_order_relaxed);
+
+    qnode * predecessor = m_tail.exchange(n, std::memory_order_acq_rel);
+    if (predecessor != nullptr)
+    {
+        predecessor->next.store(n, std::memory_order_release);
+
+        backoff b;
+        while (n->locked.load(std::memory_order_acquire))
+            b.pause();
+    }
+    m_owner_node = n;
+}
+
+/**
+ *  Takes the lock only if nobody holds it or waits for it.
+ *
+ * \return
+ *      Returns true if the lock was obtained.
+ */
+
+bool
+queuemutex::try_lock ()
+{
+    if (m_tail.load(std::memory_order_relaxed) != nullptr)
+        return false;
+
+    qnode * n = acquire_node();
+    n->next.store(nullptr, std::memory_order_relaxed);
+    n->locked.store(false, std::memory_order_relaxed);
+
+    qnode * expected = nullptr;
+    bool result = m_tail.compare_exchange_strong
+    (
+        expected, n, std::memory_order_acq_rel, std::memory_order_relaxed
+    );
+    if (result)
+        m_owner_node = n;
+    else
+        release_node(n);
+
+    return result;
+}
+
+/**
+ *  Hands the lock to the next waiter.  If there seems to be none, we try to
+ *  mark the lock free.  That fails if a new waiter has just swapped itself
+ *  into the tail; then we wait for it to link itself behind us, and hand
+ *  off to it.
+ */
+
+void
+queuemutex::unlock ()
+{
+    qnode * n = m_owner_node;
+    qnode * successor = n->next.load(std::memory_order_acquire);
+    if (successor == nullptr)
+    {
+        qnode * expected = n;
+        if
+        (
+            m_tail.compare_exchange_strong
+            (
+                expected, nullptr,
+                std::memory_order_release, std::memory_order_relaxed
+            )
+        )
+        {
+            release_node(n);
+            return;
+        }
+        backoff b;
+        for (;;)
+        {
+            successor = n->next.load(std::memory_order_acquire);
+            if (successor != nullptr)
+                break;
+
+            b.pause();
+        }
+    }
+    successor->locked.store(false, std::memory_order_release);
+    release_node(n);
+}
+
+}           // namespace xpc
+
+/*
+ * queuemutex.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -24,7 +24,7 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2015-07-24
- * \updates       2024-01-16
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  Seq66 needs a mutex for sequencer operations. We have finally, after a
@@ -32,6 +32,7 @@
  *  std::mutex, decided to stick with the old pthreads implementation for now.
  */
 
+#include "xpc/lockorder.hpp"            /* lock_order_acquire(), etc.       */
 #include "xpc/recmutex.hpp"             /* xpc::recmutex                    */
 
 /**
@@ -100,44 +101,34 @@ namespace xpc
 {
 
 /**
- *  Define the static recursive mutex and its condition variable.
- */
-
-recmutex::native recmutex::sm_global_mutex;
-
-#if defined USE_GLOBAL_MUTEX
-
-/**
- *  We need a static flag to guarantee that the static native mutex object
- *  is initialized.
+ *  Constructor for recmutex.
  */
 
-void
-recmutex::init_global_mutex ()
+recmutex::recmutex () :
+#if defined PLATFORM_FREEBSD
+    m_mutex_attributes  (),             /* uninit'd pthread_mutexattr_t     */
+#endif
+    m_mutex_lock    (),                 /* uninitialized pthread_mutex_t    */
+    m_name          (nullptr)
 {
-    static bool s_global_mutex_initialized = false;
-    if (! s_global_mutex_initialized)
-    {
-        s_global_mutex_initialized = true;
-        recmutex::sm_global_mutex = MUTEX_INITIALIZER;
-    }
+    init();
 }
 
-#endif
-
 /**
- *  Constructor for recmutex.
+ *  Constructor for a named recmutex.  The name shows up in lock-order
+ *  reports in debug builds.
+ *
+ * \param name
+ *      A string that outlives the mutex, normally a literal.
  */
 
-recmutex::recmutex () :
+recmutex::recmutex (const char * name) :
 #if defined PLATFORM_FREEBSD
-    m_mutex_attributes  (),             /* uninit'd pthread_mutexattr_t     */
+    m_mutex_attributes  (),
 #endif
-    m_mutex_lock () /* uninitialized pthread_mutex_t    */
+    m_mutex_lock    (),
+    m_name          (name)
 {
-#if defined USE_GLOBAL_MUTEX
-    init_global_mutex();                /* might not need global mutex, tho */
-#endif
     init();
 }
 
@@ -147,17 +138,23 @@ recmutex::recmutex () :
  *
  *  However, there are objects that use a mutex and should still be copyable.
  *  So rather than defining a default copy constructor or deleting it, we
- *  make one that creates a new mutex. We do not need to call the static
- *  function init_global_mutex().  We could call it, but nothing would happen.
+ *  make one that creates a new mutex.
  */
 
-recmutex::recmutex (const recmutex & /* rhs */ ) : m_mutex_lock ()
+recmutex::recmutex (const recmutex & rhs) :
+#if defined PLATFORM_FREEBSD
+    m_mutex_attributes  (),
+#endif
+    m_mutex_lock    (),
+    m_name          (rhs.m_name)
 {
     init();
 }
 
 /**
- *  Similarly, we want to support the principal assignment operator.
+ *  Similarly, we want to support the principal assignment operator.  The
+ *  name is copied, as in the copy constructor, so that lock-order reports
+ *  still name the mutex.
  */
 
 recmutex &
@@ -165,9 +162,7 @@ recmutex::operator = (const recmutex & rhs)
 {
     if (this != & rhs)
     {
-#if defined USE_GLOBAL_MUTEX
-        init_global_mutex();
-#endif
+        m_name = rhs.m_name;
         init();
     }
     return *this;
@@ -175,16 +170,24 @@ recmutex::operator = (const recmutex & rhs)
 
 recmutex::~recmutex ()
 {
+#if defined XPC66_LOCK_ORDER_CHECK
+    lock_order_forget(this);
+#endif
     destroy();
 }
 
 /**
- *  Locks the recmutex.
+ *  Locks the recmutex.  In debug builds, the lock-order checker sees the
+ *  request first, so that an inversion is reported even if this call then
+ *  deadlocks.
  */
 
 void
 recmutex::lock () const
 {
+#if defined XPC66_LOCK_ORDER_CHECK
+    lock_order_acquire(this);
+#endif
     (void) pthread_mutex_lock(&m_mutex_lock);
 }
 
@@ -196,6 +199,9 @@ void
 recmutex::unlock () const
 {
     (void) pthread_mutex_unlock(&m_mutex_lock);
+#if defined XPC66_LOCK_ORDER_CHECK
+    lock_order_release(this);
+#endif
 }
 
 /**
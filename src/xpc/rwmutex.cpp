@@ -0,0 +1,206 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          rwmutex.cpp
+ *
+ *  This module defines the reader-writer lock.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  POSIX leaves the reader/writer preference of pthread_rwlock_t up to the
+ *  implementation, and glibc prefers readers by default.  For the
+ *  writer-preferring policy we use the glibc extension
+ *  pthread_rwlockattr_setkind_np().  On other platforms both policies map to
+ *  the default lock.
+ */
+
+#include "xpc/rwmutex.hpp"              /* xpc::rwmutex                     */
+
+#if defined PLATFORM_LINUX && defined __GLIBC__
+#define XPC66_HAVE_RWLOCK_KIND
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  Constructor for rwmutex.
+ *
+ * \param p
+ *      The reader/writer preference.  The default is
+ *      policy::writer_preferred, so that a rare writer is not starved by
+ *      the many readers.
+ */
+
+rwmutex::rwmutex (policy p) :
+    m_policy    (p),
+    m_rw_lock   ()                      /* uninitialized pthread_rwlock_t   */
+{
+    init();
+}
+
+/**
+ *  Copy constructor.  As with recmutex, copying a lock makes no sense, but
+ *  objects containing one should still be copyable.  So we make a new lock
+ *  with the same policy.
+ */
+
+rwmutex::rwmutex (const rwmutex & rhs) :
+    m_policy    (rhs.m_policy),
+    m_rw_lock   ()
+{
+    init();
+}
+
+/**
+ *  Similarly, we want to support the principal assignment operator.  The
+ *  lock is rebuilt with the new policy; the caller must not hold it.
+ */
+
+rwmutex &
+rwmutex::operator = (const rwmutex & rhs)
+{
+    if (this != & rhs)
+    {
+        destroy();
+        m_policy = rhs.m_policy;
+        init();
+    }
+    return *this;
+}
+
+rwmutex::~rwmutex ()
+{
+    destroy();
+}
+
+/**
+ *  Takes the exclusive (write) lock.
+ */
+
+void
+rwmutex::lock () const
+{
+    (void) pthread_rwlock_wrlock(&m_rw_lock);
+}
+
+/**
+ *  Releases either kind of lock.  pthreads uses the same call for both.
+ */
+
+void
+rwmutex::unlock () const
+{
+    (void) pthread_rwlock_unlock(&m_rw_lock);
+}
+
+/**
+ *  Tries to take the exclusive lock without blocking.
+ *
+ * \return
+ *      Returns true if the lock was obtained.
+ */
+
+bool
+rwmutex::try_lock () const
+{
+    return pthread_rwlock_trywrlock(&m_rw_lock) == 0;
+}
+
+/**
+ *  Takes a shared (read) lock.  Do not call this function again in a thread
+ *  that already holds a shared lock on this rwmutex.
+ */
+
+void
+rwmutex::lock_shared () const
+{
+    (void) pthread_rwlock_rdlock(&m_rw_lock);
+}
+
+void
+rwmutex::unlock_shared () const
+{
+    (void) pthread_rwlock_unlock(&m_rw_lock);
+}
+
+/**
+ *  Tries to take a shared lock without blocking.
+ *
+ * \return
+ *      Returns true if the lock was obtained.
+ */
+
+bool
+rwmutex::try_lock_shared () const
+{
+    return pthread_rwlock_tryrdlock(&m_rw_lock) == 0;
+}
+
+/**
+ *  Initializes the lock according to the policy.  The "nonrecursive"
+ *  writer-preference kind is the only glibc kind that actually prefers
+ *  writers; the plain PTHREAD_RWLOCK_PREFER_WRITER_NP acts like the reader
+ *  preference.
+ */
+
+void
+rwmutex::init ()
+{
+    pthread_rwlockattr_t attributes;
+    int rc = pthread_rwlockattr_init(&attributes);
+    if (rc == 0)
+    {
+#if defined XPC66_HAVE_RWLOCK_KIND
+        int kind = m_policy == policy::writer_preferred ?
+            PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP :
+            PTHREAD_RWLOCK_PREFER_READER_NP ;
+
+        (void) pthread_rwlockattr_setkind_np(&attributes, kind);
+#endif
+        rc = pthread_rwlock_init(&m_rw_lock, &attributes);
+        (void) pthread_rwlockattr_destroy(&attributes);
+    }
+    if (rc != 0)
+    {
+        // what to do?
+    }
+}
+
+void
+rwmutex::destroy ()
+{
+    (void) pthread_rwlock_destroy(&m_rw_lock);
+}
+
+}           // namespace xpc
+
+/*
+ * rwmutex.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
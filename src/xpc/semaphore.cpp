@@ -0,0 +1,248 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          semaphore.cpp
+ *
+ *  This module defines the futex-based semaphore and auto-reset event.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  No lost wakeups:  a waiter increments m_waiters before futex_wait()
+ *  checks the value, and a poster changes the value before it loads
+ *  m_waiters.  All of these are sequentially consistent, so either the
+ *  poster sees the waiter and wakes it, or futex_wait() sees the new value
+ *  and does not sleep.
+ */
+
+#include <chrono>                       /* std::chrono::steady_clock        */
+
+#include "xpc/cpu_hints.hpp"            /* xpc::cpu_relax()                 */
+#include "xpc/futex.hpp"                /* xpc::futex_wait(), futex_wake()  */
+#include "xpc/semaphore.hpp"            /* xpc::semaphore, xpc::autoevent   */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+namespace
+{
+
+/**
+ *  The number of times a waiter polls before going to sleep.
+ */
+
+const int c_spin_limit = 100;
+
+using clock = std::chrono::steady_clock;
+
+/**
+ *  The wait loop shared by both classes.  The "take" function tries to
+ *  consume the value without blocking; while it fails, we sleep as long as
+ *  the word is zero.
+ *
+ * \param timeout_us
+ *      The longest wait in microseconds, or a negative value for no limit.
+ *
+ * \return
+ *      Returns true if the value was taken, false on timeout.
+ */
+
+template <typename TAKE>
+bool
+wait_on
+(
+    std::atomic<int> & word, std::atomic<int> & waiters,
+    TAKE take, long long timeout_us
+)
+{
+    int limit = spin_worthwhile() ? c_spin_limit : 0 ;
+    for (int spin = 0; spin < limit; ++spin)
+    {
+        if (take())
+            return true;
+
+        cpu_relax();
+    }
+
+    clock::time_point deadline;
+    if (timeout_us >= 0)
+        deadline = clock::now() + std::chrono::microseconds(timeout_us);
+
+    for (;;)
+    {
+        if (take())
+            return true;
+
+        long long ns = -1;
+        if (timeout_us >= 0)
+        {
+            ns = (long long) std::chrono::duration_cast
+            <
+                std::chrono::nanoseconds
+            >(deadline - clock::now()).count();
+            if (ns <= 0)
+                return false;
+        }
+        waiters.fetch_add(1);
+        (void) futex_wait(word, 0, ns);
+        waiters.fetch_sub(1);
+    }
+}
+
+}           // anonymous namespace
+
+/*
+ * --------------------------------------------------------------------------
+ *  semaphore
+ * --------------------------------------------------------------------------
+ */
+
+semaphore::semaphore (int initial) :
+    m_count     (initial > 0 ? initial : 0),
+    m_waiters   (0)
+{
+    // no code
+}
+
+/**
+ *  Adds to the count, waking as many sleepers as were added.
+ */
+
+void
+semaphore::post (int n)
+{
+    if (n <= 0)
+        return;
+
+    m_count.fetch_add(n);
+    if (m_waiters.load() > 0)
+        futex_wake(m_count, n);
+}
+
+/**
+ *  Takes one from the count if it is not zero.
+ *
+ * \return
+ *      Returns true if a count was taken.
+ */
+
+bool
+semaphore::try_wait ()
+{
+    int c = m_count.load(std::memory_order_relaxed);
+    while (c > 0)
+    {
+        if (m_count.compare_exchange_weak(c, c - 1))
+            return true;
+    }
+    return false;
+}
+
+void
+semaphore::wait ()
+{
+    (void) wait_on(m_count, m_waiters, [this] { return try_wait(); }, -1);
+}
+
+/**
+ * \return
+ *      Returns true if a count was taken, false if "us" microseconds passed
+ *      first.
+ */
+
+bool
+semaphore::wait_for (int us)
+{
+    return wait_on
+    (
+        m_count, m_waiters, [this] { return try_wait(); },
+        us > 0 ? us : 0
+    );
+}
+
+/*
+ * --------------------------------------------------------------------------
+ *  autoevent
+ * --------------------------------------------------------------------------
+ */
+
+autoevent::autoevent (bool initially_set) :
+    m_state     (initially_set ? 1 : 0),
+    m_waiters   (0)
+{
+    // no code
+}
+
+/**
+ *  Sets the event.  Only the setting of a clear event can need a wake; if it
+ *  was set already, nobody can have gone to sleep since.
+ */
+
+void
+autoevent::signal ()
+{
+    if (m_state.exchange(1) == 0)
+    {
+        if (m_waiters.load() > 0)
+            futex_wake(m_state, 1);
+    }
+}
+
+/**
+ * \return
+ *      Returns true if the event was set (and is now cleared by us).
+ */
+
+bool
+autoevent::try_wait ()
+{
+    int expected = 1;
+    return m_state.compare_exchange_strong(expected, 0);
+}
+
+void
+autoevent::wait ()
+{
+    (void) wait_on(m_state, m_waiters, [this] { return try_wait(); }, -1);
+}
+
+bool
+autoevent::wait_for (int us)
+{
+    return wait_on
+    (
+        m_state, m_waiters, [this] { return try_wait(); },
+        us > 0 ? us : 0
+    );
+}
+
+}           // namespace xpc
+
+/*
+ * semaphore.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,281 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          stoptoken.cpp
+ *
+ *  This module defines stop_source, stop_token, and stop_callback.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  request_stop() does three things, in this order:
+ *
+ *      -#  Sets the stop word and futex-wakes everything sleeping on it
+ *          (the token versions of microsleep() and millisleep()).
+ *      -#  Signals the notifier, if one was created, for wait_any() users.
+ *      -#  Runs the callbacks.
+ *
+ *  The first two are request_stop_async(), which uses only atomics, the
+ *  futex system call, and an eventfd write, so a signal handler may call
+ *  it.  The third is run_callbacks().
+ *
+ *  Callbacks are run one at a time: each is taken off the list under the
+ *  state mutex, which is then released while it runs.  A callback usually
+ *  takes a lock of its own (condition::wait(token) takes the condition's
+ *  lock), and the thread holding that lock may be registering a
+ *  stop_callback, which needs the state mutex; holding the mutex across
+ *  the callback would deadlock.  A stop_callback destroyed before its turn
+ *  is just removed from the list; one destroyed while its function runs in
+ *  another thread waits for it on m_done.
+ */
+
+#include "xpc/futex.hpp"                /* xpc::futex_wake_all()            */
+#include "xpc/notifier.hpp"             /* xpc::notifier                    */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_source, etc.           */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/*
+ * --------------------------------------------------------------------------
+ *  stop_state
+ * --------------------------------------------------------------------------
+ */
+
+stop_state::stop_state () :
+    m_stopped           (0),
+    m_mutex             (),
+    m_callbacks         (),
+    m_next_id           (0),
+    m_running_id        (0),
+    m_running_thread    (),
+    m_done              (),
+    m_dispatching       (false),
+    m_notifier          (),
+    m_notifier_ptr      (nullptr)
+{
+    // no code
+}
+
+stop_state::~stop_state ()
+{
+    // defined here, where notifier is a complete type
+}
+
+/*
+ * --------------------------------------------------------------------------
+ *  stop_token
+ * --------------------------------------------------------------------------
+ */
+
+/**
+ *  Gets an object that becomes ready when the stop is requested, for use in
+ *  wait_any().  The notifier behind it (a file descriptor) is created on
+ *  the first call, and is never drained, so it stays ready.
+ *
+ * \return
+ *      Returns null for a token with no source.
+ */
+
+const waitable *
+stop_token::get_waitable () const
+{
+    if (! m_state)
+        return nullptr;
+
+    std::lock_guard<std::mutex> guard(m_state->m_mutex);
+    if (! m_state->m_notifier)
+    {
+        m_state->m_notifier.reset(new notifier());
+        m_state->m_notifier_ptr.store(m_state->m_notifier.get());
+        if (m_state->m_stopped.load() != 0)
+            m_state->m_notifier->signal();
+    }
+    return m_state->m_notifier.get();
+}
+
+/*
+ * --------------------------------------------------------------------------
+ *  stop_source
+ * --------------------------------------------------------------------------
+ */
+
+stop_source::stop_source () :
+    m_state (std::make_shared<stop_state>())
+{
+    // no code
+}
+
+/**
+ *  Requests the stop, and runs the callbacks.
+ *
+ * \return
+ *      Returns true if this call made the request, false if the stop had
+ *      already been requested.
+ */
+
+bool
+stop_source::request_stop ()
+{
+    bool result = request_stop_async();
+    run_callbacks();
+    return result;
+}
+
+/**
+ *  Requests the stop without running the callbacks.  In Linux it is
+ *  async-signal-safe; elsewhere futex_wake_all() locks a std::mutex, so it
+ *  is not.  The sleeps, waits, and waitable of the tokens see
+ *  the stop at once, but a wait that relies on a callback, such as
+ *  condition::wait(token), wakes only when run_callbacks() is called.
+ *
+ * \return
+ *      Returns true if this call made the request.
+ */
+
+bool
+stop_source::request_stop_async ()
+{
+    stop_state & s = *m_state;
+    if (s.m_stopped.exchange(1) != 0)
+        return false;
+
+    futex_wake_all(s.m_stopped);
+
+    /*
+     * If get_waitable() creates the notifier after this load, it sees the
+     * stop word set and signals it itself.
+     */
+
+    notifier * n = s.m_notifier_ptr.load();
+    if (n != nullptr)
+        n->signal();
+
+    return true;
+}
+
+/**
+ *  Runs the callbacks of a stop requested by request_stop_async().  It
+ *  does nothing if the stop was not requested, or if another thread is
+ *  running them already, so it is cheap to call from a polling loop.
+ */
+
+void
+stop_source::run_callbacks ()
+{
+    stop_state & s = *m_state;
+    if (s.m_stopped.load() == 0)
+        return;
+
+    std::unique_lock<std::mutex> lock(s.m_mutex);
+    if (s.m_dispatching)
+        return;
+
+    s.m_dispatching = true;
+    while (! s.m_callbacks.empty())
+    {
+        auto it = s.m_callbacks.begin();
+        std::function<void ()> f = std::move(it->second);
+        s.m_running_id = it->first;
+        s.m_running_thread = std::this_thread::get_id();
+        s.m_callbacks.erase(it);
+        lock.unlock();
+        f();
+        lock.lock();
+        s.m_running_id = 0;
+        s.m_done.notify_all();
+    }
+    s.m_dispatching = false;
+}
+
+/*
+ * --------------------------------------------------------------------------
+ *  stop_callback
+ * --------------------------------------------------------------------------
+ */
+
+/**
+ *  Registers the function, or, if the stop was already requested, runs it
+ *  right here.  A token with no source never runs it.
+ */
+
+stop_callback::stop_callback
+(
+    const stop_token & token, std::function<void ()> f
+) :
+    m_state (token.m_state),
+    m_id    (0)
+{
+    if (m_state)
+    {
+        bool run_now = false;
+        {
+            std::lock_guard<std::mutex> guard(m_state->m_mutex);
+            if (m_state->m_stopped.load() != 0)
+                run_now = true;
+            else
+            {
+                m_id = ++m_state->m_next_id;
+                m_state->m_callbacks.emplace(m_id, f);
+            }
+        }
+        if (run_now)
+            f();
+    }
+}
+
+/**
+ *  Unregisters the function.  If it is running in another thread, waits
+ *  for it to return; if it is running in this thread (it destroys its own
+ *  stop_callback), does not.
+ */
+
+stop_callback::~stop_callback ()
+{
+    if (m_state && m_id != 0)
+    {
+        stop_state & s = *m_state;
+        std::unique_lock<std::mutex> lock(s.m_mutex);
+        if (s.m_callbacks.erase(m_id) == 0)
+        {
+            if (s.m_running_thread != std::this_thread::get_id())
+            {
+                s.m_done.wait
+                (
+                    lock, [this, &s] { return s.m_running_id != m_id; }
+                );
+            }
+        }
+    }
+}
+
+}           // namespace xpc
+
+/*
+ * stoptoken.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,63 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          stripedmutex.cpp
+ *
+ *  This module defines the process-wide striped lock table.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  The table template is defined in the header.  This module only holds the
+ *  one shared instance, which replaces the old static "global" mutexes of
+ *  recmutex and condition.
+ */
+
+#include "xpc/stripedmutex.hpp"         /* xpc::stripedmutex, autostripe    */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  Returns the process-wide stripe table.  It is a function-local static so
+ *  that it is constructed on first use, even from the constructors of other
+ *  static objects.
+ */
+
+global_stripe_table &
+global_stripes ()
+{
+    static global_stripe_table s_global_stripes;
+    return s_global_stripes;
+}
+
+}           // namespace xpc
+
+/*
+ * stripedmutex.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
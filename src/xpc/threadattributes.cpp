@@ -0,0 +1,654 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          threadattributes.cpp
+ *
+ *  This module defines the thread_attributes builder.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  glibc has no wrapper for sched_setattr(2), which SCHED_DEADLINE needs,
+ *  so it is called through syscall() with the kernel's struct sched_attr,
+ *  declared here.
+ *
+ *  The stack is prefaulted by alloca() of the requested size in a
+ *  function that is not inlined, writing one byte per page.  The pages
+ *  stay mapped after it returns, ready for the thread body.  The size is
+ *  checked against the thread's actual stack size first.
+ */
+
+#include <cerrno>                       /* EINVAL, ENOTSUP, EPERM           */
+#include <cstring>                      /* std::strerror()                  */
+#include <future>                       /* std::promise<>, std::future<>    */
+#include <system_error>                 /* std::system_error                */
+#include <utility>                      /* std::move()                      */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX, PLATFORM_UNIX    */
+#include "xpc/threadattributes.hpp"     /* xpc::thread_attributes           */
+
+#if defined PLATFORM_UNIX
+#include <alloca.h>                     /* alloca()                         */
+#include <pthread.h>                    /* pthread_setschedparam(), etc.    */
+#include <sched.h>                      /* SCHED_FIFO, cpu_set_t            */
+#include <unistd.h>                     /* sysconf()                        */
+#endif
+
+#if defined PLATFORM_LINUX
+#include <sys/resource.h>               /* setpriority()                    */
+#include <sys/syscall.h>                /* SYS_sched_setattr, SYS_gettid    */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+namespace
+{
+
+/**
+ *  Builds a failed status.
+ */
+
+thread_status
+failure (thread_status::step s, int error, const std::string & what)
+{
+    thread_status result;
+    result.failed = s;
+    result.error = error;
+    result.message = what + ": " + std::strerror(error);
+    return result;
+}
+
+#if defined PLATFORM_LINUX
+
+#if ! defined SCHED_DEADLINE
+#define SCHED_DEADLINE      6
+#endif
+
+/**
+ *  The kernel's argument to sched_setattr(2).
+ */
+
+struct sched_attr_type
+{
+    std::uint32_t size;
+    std::uint32_t sched_policy;
+    std::uint64_t sched_flags;
+    std::int32_t sched_nice;
+    std::uint32_t sched_priority;
+    std::uint64_t sched_runtime;
+    std::uint64_t sched_deadline;
+    std::uint64_t sched_period;
+};
+
+#endif
+
+#if defined PLATFORM_UNIX
+
+/**
+ *  Touches each page of "bytes" of stack below the caller's frame.
+ */
+
+__attribute__((noinline)) void
+touch_stack (std::size_t bytes)
+{
+    volatile char * p = static_cast<volatile char *>(alloca(bytes));
+    long page = sysconf(_SC_PAGESIZE);
+    std::size_t step = page > 0 ? std::size_t(page) : 4096 ;
+    for (std::size_t i = 0; i < bytes; i += step)
+        p[i] = 0;
+
+    p[bytes - 1] = 0;
+}
+
+#endif
+
+}           // anonymous namespace
+
+thread_attributes::thread_attributes () :
+    m_policy            (policy::inherit),
+    m_priority          (0),
+    m_runtime_ns        (0),
+    m_deadline_ns       (0),
+    m_period_ns         (0),
+    m_cpus              (),
+    m_name              (),
+    m_prefault_bytes    (0),
+    m_best_effort       (false)
+{
+    // no code
+}
+
+/**
+ *  Selects SCHED_FIFO.
+ *
+ * \param priority
+ *      The real-time priority, 1 (low) to 99 (high) in Linux.  It is
+ *      checked against the policy's range when applied.
+ */
+
+thread_attributes &
+thread_attributes::fifo (int priority)
+{
+    m_policy = policy::fifo;
+    m_priority = priority;
+    return *this;
+}
+
+/**
+ *  Selects SCHED_RR, which is SCHED_FIFO with time slices among threads of
+ *  the same priority.
+ */
+
+thread_attributes &
+thread_attributes::round_robin (int priority)
+{
+    m_policy = policy::round_robin;
+    m_priority = priority;
+    return *this;
+}
+
+/**
+ *  Selects SCHED_OTHER, the normal time-sharing policy.
+ *
+ * \param nice
+ *      The nice value, -20 (favored) to 19.  Values below 0 need
+ *      privileges.
+ */
+
+thread_attributes &
+thread_attributes::other (int nice)
+{
+    m_policy = policy::other;
+    m_priority = nice;
+    return *this;
+}
+
+/**
+ *  Selects SCHED_DEADLINE (Linux 3.14 and later): the thread gets
+ *  \a runtime_ns of CPU time in each \a period_ns, finished within
+ *  \a deadline_ns of the period's start.  They must be ordered runtime
+ *  <= deadline <= period.  A period of 0 means the period equals the
+ *  deadline, as in sched_setattr(2).
+ *
+ *  The kernel refuses SCHED_DEADLINE for a thread whose affinity is
+ *  narrower than its root domain (EPERM), so it cannot be combined with
+ *  affinity(); apply() and launch() reject that combination before
+ *  changing anything.  To pin deadline threads, use an exclusive cpuset
+ *  instead.
+ */
+
+thread_attributes &
+thread_attributes::deadline
+(
+    std::int64_t runtime_ns,
+    std::int64_t deadline_ns,
+    std::int64_t period_ns
+)
+{
+    m_policy = policy::deadline;
+    m_runtime_ns = runtime_ns;
+    m_deadline_ns = deadline_ns;
+    m_period_ns = period_ns;
+    return *this;
+}
+
+/**
+ *  Sets the CPUs the thread may run on, numbered from 0.
+ */
+
+thread_attributes &
+thread_attributes::affinity (std::initializer_list<int> cpus)
+{
+    m_cpus.assign(cpus.begin(), cpus.end());
+    return *this;
+}
+
+thread_attributes &
+thread_attributes::affinity (const std::vector<int> & cpus)
+{
+    m_cpus = cpus;
+    return *this;
+}
+
+/**
+ *  Sets the thread name shown by ps, top, and debuggers.
+ */
+
+thread_attributes &
+thread_attributes::name (const std::string & n)
+{
+    m_name = n;
+    return *this;
+}
+
+/**
+ *  Sets the number of bytes of stack to fault in before the body runs, so
+ *  that its first calls do not take page faults.  It must be well under
+ *  the thread's stack size (8 MiB by default in Linux).  Combine it with
+ *  mlockall(MCL_CURRENT | MCL_FUTURE) in the process to keep the pages.
+ */
+
+thread_attributes &
+thread_attributes::prefault_stack (std::size_t bytes)
+{
+    m_prefault_bytes = bytes;
+    return *this;
+}
+
+/**
+ *  If set, launch() runs the body even if a setting fails, as on a
+ *  development machine without real-time privileges.  The status still
+ *  reports the failure.
+ */
+
+thread_attributes &
+thread_attributes::best_effort (bool flag)
+{
+    m_best_effort = flag;
+    return *this;
+}
+
+/**
+ *  Checks the settings that can be checked before any is applied: the
+ *  SCHED_DEADLINE parameters, and that SCHED_DEADLINE is not combined with
+ *  an affinity.
+ */
+
+thread_status
+thread_attributes::validate () const
+{
+    if (m_policy != policy::deadline)
+        return thread_status();
+
+    if (m_runtime_ns <= 0 || m_runtime_ns > m_deadline_ns ||
+        m_period_ns < 0 || (m_period_ns > 0 && m_deadline_ns > m_period_ns))
+    {
+        thread_status result = failure
+        (
+            thread_status::step::policy, EINVAL, "SCHED_DEADLINE"
+        );
+        result.message += ", need runtime <= deadline <= period";
+        return result;
+    }
+    if (! m_cpus.empty())
+    {
+        thread_status result = failure
+        (
+            thread_status::step::policy, EINVAL, "SCHED_DEADLINE"
+        );
+        result.message += ", cannot be combined with an affinity";
+        return result;
+    }
+    return thread_status();
+}
+
+/**
+ *  Applies the settings to the calling thread, in the order name,
+ *  affinity, stack, policy.  It stops at the first failure, unless
+ *  best_effort() is set; then it applies the rest, and reports the first
+ *  failure.  Settings that validate() refuses fail before anything is
+ *  applied, even with best_effort().
+ */
+
+thread_status
+thread_attributes::apply () const
+{
+    thread_status result = validate();
+    if (! result.ok())
+        return result;
+
+    thread_status (thread_attributes::* const steps [])() const =
+    {
+        &thread_attributes::apply_name,
+        &thread_attributes::apply_affinity,
+        &thread_attributes::apply_stack,
+        &thread_attributes::apply_policy
+    };
+    for (auto step : steps)
+    {
+        thread_status s = (this->*step)();
+        if (! s.ok())
+        {
+            if (result.ok())
+                result = s;
+
+            if (! m_best_effort)
+                break;
+        }
+    }
+    return result;
+}
+
+/**
+ *  Starts a thread that applies the settings and then runs the body.
+ *
+ * \param [out] t
+ *      The new thread.  It must not be joinable.  It is left empty if the
+ *      thread could not start, or a setting failed and best_effort() was
+ *      not set.
+ *
+ * \param body
+ *      The thread function.
+ *
+ * \return
+ *      Returns the outcome of applying the settings, once they are applied.
+ */
+
+thread_status
+thread_attributes::launch (std::thread & t, std::function<void ()> body) const
+{
+    if (t.joinable())
+        return failure(thread_status::step::launch, EINVAL, "thread running");
+
+    std::promise<thread_status> handshake;
+    std::future<thread_status> outcome = handshake.get_future();
+    thread_attributes attributes = *this;
+    try
+    {
+        t = std::thread
+        (
+            [attributes] (std::promise<thread_status> p,
+                std::function<void ()> f)
+            {
+                thread_status s = attributes.apply();
+                bool run = s.ok() || attributes.m_best_effort;
+                p.set_value(std::move(s));
+                if (run)
+                    f();
+            },
+            std::move(handshake), std::move(body)
+        );
+    }
+    catch (const std::system_error & e)
+    {
+        return failure
+        (
+            thread_status::step::launch, e.code().value(), "std::thread"
+        );
+    }
+
+    thread_status result = outcome.get();
+    if (! result.ok() && ! m_best_effort)
+        t.join();
+
+    return result;
+}
+
+#if defined PLATFORM_LINUX
+
+thread_status
+thread_attributes::apply_name () const
+{
+    if (m_name.empty())
+        return thread_status();
+
+    std::string n = m_name.substr(0, 15);
+    int rc = pthread_setname_np(pthread_self(), n.c_str());
+    if (rc != 0)
+        return failure(thread_status::step::name, rc, "pthread_setname_np");
+
+    return thread_status();
+}
+
+thread_status
+thread_attributes::apply_affinity () const
+{
+    if (m_cpus.empty())
+        return thread_status();
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : m_cpus)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+            return failure(thread_status::step::affinity, EINVAL, "CPU");
+
+        CPU_SET(cpu, &set);
+    }
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof set, &set);
+    if (rc != 0)
+    {
+        return failure
+        (
+            thread_status::step::affinity, rc, "pthread_setaffinity_np"
+        );
+    }
+    return thread_status();
+}
+
+thread_status
+thread_attributes::apply_stack () const
+{
+    if (m_prefault_bytes == 0)
+        return thread_status();
+
+    pthread_attr_t attr;
+    std::size_t stacksize = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0)
+    {
+        (void) pthread_attr_getstacksize(&attr, &stacksize);
+        (void) pthread_attr_destroy(&attr);
+    }
+    if (stacksize > 0 && m_prefault_bytes > stacksize / 2)
+    {
+        return failure
+        (
+            thread_status::step::stack, EINVAL, "more than half the stack"
+        );
+    }
+    touch_stack(m_prefault_bytes);
+    return thread_status();
+}
+
+thread_status
+thread_attributes::apply_policy () const
+{
+    switch (m_policy)
+    {
+    case policy::inherit:
+
+        return thread_status();
+
+    case policy::other:
+    {
+        struct sched_param param;
+        param.sched_priority = 0;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        if (rc != 0)
+        {
+            return failure
+            (
+                thread_status::step::policy, rc, "SCHED_OTHER"
+            );
+        }
+
+        pid_t tid = pid_t(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, id_t(tid), m_priority) != 0)
+            return failure(thread_status::step::policy, errno, "nice");
+
+        return thread_status();
+    }
+
+    case policy::fifo:
+    case policy::round_robin:
+    {
+        int p = m_policy == policy::fifo ? SCHED_FIFO : SCHED_RR ;
+        const char * tag = m_policy == policy::fifo ?
+            "SCHED_FIFO" : "SCHED_RR" ;
+
+        int minp = sched_get_priority_min(p);
+        int maxp = sched_get_priority_max(p);
+        if (m_priority < minp || m_priority > maxp)
+        {
+            thread_status result = failure
+            (
+                thread_status::step::policy, EINVAL, tag
+            );
+            result.message += ", priority " + std::to_string(m_priority) +
+                " outside of " + std::to_string(minp) + "-" +
+                std::to_string(maxp);
+
+            return result;
+        }
+
+        struct sched_param param;
+        param.sched_priority = m_priority;
+        int rc = pthread_setschedparam(pthread_self(), p, &param);
+        if (rc != 0)
+            return failure(thread_status::step::policy, rc, tag);
+
+        return thread_status();
+    }
+
+    case policy::deadline:
+    {
+#if defined SYS_sched_setattr
+        sched_attr_type attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size = sizeof attr;
+        attr.sched_policy = SCHED_DEADLINE;
+        attr.sched_runtime = std::uint64_t(m_runtime_ns);
+        attr.sched_deadline = std::uint64_t(m_deadline_ns);
+        attr.sched_period = std::uint64_t(m_period_ns);
+        if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0)
+        {
+            return failure
+            (
+                thread_status::step::policy, errno, "SCHED_DEADLINE"
+            );
+        }
+        return thread_status();
+#else
+        return failure
+        (
+            thread_status::step::policy, ENOTSUP, "SCHED_DEADLINE"
+        );
+#endif
+    }
+
+    }
+    return thread_status();
+}
+
+#elif defined PLATFORM_UNIX
+
+/*
+ *  Other POSIX threads:  the policies without nice, and the stack.
+ */
+
+thread_status
+thread_attributes::apply_name () const
+{
+    return m_name.empty() ? thread_status() :
+        failure(thread_status::step::name, ENOTSUP, "thread name") ;
+}
+
+thread_status
+thread_attributes::apply_affinity () const
+{
+    return m_cpus.empty() ? thread_status() :
+        failure(thread_status::step::affinity, ENOTSUP, "affinity") ;
+}
+
+thread_status
+thread_attributes::apply_stack () const
+{
+    if (m_prefault_bytes > 0)
+        touch_stack(m_prefault_bytes);
+
+    return thread_status();
+}
+
+thread_status
+thread_attributes::apply_policy () const
+{
+    int p;
+    switch (m_policy)
+    {
+    case policy::inherit:       return thread_status();
+    case policy::other:         p = SCHED_OTHER;            break;
+    case policy::fifo:          p = SCHED_FIFO;             break;
+    case policy::round_robin:   p = SCHED_RR;               break;
+    default:
+
+        return failure(thread_status::step::policy, ENOTSUP, "policy");
+    }
+    if (m_policy == policy::other && m_priority != 0)
+        return failure(thread_status::step::policy, ENOTSUP, "nice");
+
+    struct sched_param param;
+    param.sched_priority = m_policy == policy::other ? 0 : m_priority ;
+    int rc = pthread_setschedparam(pthread_self(), p, &param);
+    if (rc != 0)
+        return failure(thread_status::step::policy, rc, "policy");
+
+    return thread_status();
+}
+
+#else       // ! defined PLATFORM_UNIX
+
+/*
+ *  Not supported:  any setting fails with ENOTSUP.
+ */
+
+thread_status
+thread_attributes::apply_name () const
+{
+    return m_name.empty() ? thread_status() :
+        failure(thread_status::step::name, ENOTSUP, "thread name") ;
+}
+
+thread_status
+thread_attributes::apply_affinity () const
+{
+    return m_cpus.empty() ? thread_status() :
+        failure(thread_status::step::affinity, ENOTSUP, "affinity") ;
+}
+
+thread_status
+thread_attributes::apply_stack () const
+{
+    return m_prefault_bytes == 0 ? thread_status() :
+        failure(thread_status::step::stack, ENOTSUP, "stack prefault") ;
+}
+
+thread_status
+thread_attributes::apply_policy () const
+{
+    return m_policy == policy::inherit ? thread_status() :
+        failure(thread_status::step::policy, ENOTSUP, "policy") ;
+}
+
+#endif      // PLATFORM_LINUX
+
+}           // namespace xpc
+
+/*
+ * threadattributes.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
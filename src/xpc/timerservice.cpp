@@ -0,0 +1,328 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timerservice.cpp
+ *
+ *  This module defines the timerfd-backed timer service.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  The timerfd is always armed, with TFD_TIMER_ABSTIME on CLOCK_MONOTONIC,
+ *  for the earliest deadline in the queue, and disarmed when the queue is
+ *  empty.  Adding a timer only rearms it if the new deadline is earlier
+ *  than the armed one, so a batch of later timers costs no system calls.
+ *  dispatch() reads the descriptor (which makes it unreadable again), runs
+ *  the due timers, and rearms.  An armed deadline that is already past
+ *  makes the descriptor readable at once, so no timer can be lost between
+ *  dispatch() and the next epoll_wait().
+ */
+
+#include <vector>                       /* std::vector<>                    */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/timerservice.hpp"         /* xpc::timer_service               */
+#include "xpc/timing.hpp"               /* xpc::nanotime()                  */
+#include "xpc/utilfunctions.hpp"        /* xpc::error_message()             */
+
+#if defined PLATFORM_LINUX
+#include <cerrno>                       /* errno, EINTR                     */
+#include <sys/timerfd.h>                /* timerfd_create(), etc.           */
+#include <unistd.h>                     /* read(), close()                  */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ *  Creates the timerfd, non-blocking and close-on-exec.  On failure an
+ *  error is shown and valid() is false; the timers still work, but only
+ *  when the owner calls dispatch().
+ */
+
+timer_service::timer_service () :
+    m_fd        (-1),
+    m_mutex     (),
+    m_timers    (),
+    m_queue     (),
+    m_next_id   (1),
+    m_armed_ns  (0),
+    m_missed    (0)
+{
+#if defined PLATFORM_LINUX
+    m_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (m_fd < 0)
+        (void) error_message("timer_service", "timerfd_create() failed");
+#endif
+}
+
+timer_service::~timer_service ()
+{
+#if defined PLATFORM_LINUX
+    if (m_fd >= 0)
+        (void) close(m_fd);
+#endif
+}
+
+/**
+ *  Adds a one-shot timer at an absolute deadline.
+ *
+ * \param deadline_ns
+ *      The deadline on the nanotime() scale.  A deadline in the past makes
+ *      the timer due at once.
+ *
+ * \param f
+ *      The function to call.
+ *
+ * \return
+ *      Returns the id for cancel(), or 0 if \a f is empty.
+ */
+
+timer_service::timer_id
+timer_service::add_oneshot_at (std::int64_t deadline_ns, callback f)
+{
+    return add(deadline_ns, 0, std::move(f));
+}
+
+/**
+ *  Adds a one-shot timer after a delay in microseconds from now.
+ */
+
+timer_service::timer_id
+timer_service::add_oneshot (int delay_us, callback f)
+{
+    return add(nanotime() + std::int64_t(delay_us) * 1000, 0, std::move(f));
+}
+
+/**
+ *  Adds a periodic timer.
+ *
+ * \param first_deadline_ns
+ *      The first deadline on the nanotime() scale.  The later ones are at
+ *      multiples of the period after it.
+ *
+ * \param period_us
+ *      The period in microseconds.  It must be positive.
+ *
+ * \param f
+ *      The function to call on each deadline.
+ *
+ * \return
+ *      Returns the id for cancel(), or 0 if \a f is empty or the period is
+ *      not positive.
+ */
+
+timer_service::timer_id
+timer_service::add_periodic
+(
+    std::int64_t first_deadline_ns, int period_us, callback f
+)
+{
+    if (period_us <= 0)
+        return 0;
+
+    return add
+    (
+        first_deadline_ns, std::int64_t(period_us) * 1000, std::move(f)
+    );
+}
+
+timer_service::timer_id
+timer_service::add (std::int64_t deadline, std::int64_t period, callback f)
+{
+    if (! f)
+        return 0;
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+    timer_id id = m_next_id++;
+    m_timers[id] = entry{ deadline, period, std::move(f) };
+    (void) m_queue.insert(std::make_pair(deadline, id));
+    if (m_armed_ns == 0 || deadline < m_armed_ns)
+        rearm();
+
+    return id;
+}
+
+/**
+ *  Cancels a timer.  The timerfd is left armed; if it fires for nothing,
+ *  dispatch() simply finds no timer due.
+ *
+ * \return
+ *      Returns true if the timer was pending.  A one-shot timer that has
+ *      already run is no longer pending.
+ */
+
+bool
+timer_service::cancel (timer_id id)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    auto it = m_timers.find(id);
+    if (it == m_timers.end())
+        return false;
+
+    (void) m_queue.erase(std::make_pair(it->second.deadline, id));
+    (void) m_timers.erase(it);
+    return true;
+}
+
+/**
+ *  Runs the timers that are due.  Call it when the descriptor is readable,
+ *  or, without a descriptor, at next_deadline_ns().  Spurious calls are
+ *  harmless.
+ *
+ * \return
+ *      Returns the number of callbacks run.
+ */
+
+int
+timer_service::dispatch ()
+{
+#if defined PLATFORM_LINUX
+    if (m_fd >= 0)
+    {
+        std::uint64_t expirations;
+        for (;;)
+        {
+            ssize_t rc = read(m_fd, &expirations, sizeof expirations);
+            if (rc < 0 && errno == EINTR)
+                continue;
+
+            break;
+        }
+    }
+#endif
+
+    /*
+     * Collect the due timers under the lock, reschedule the periodic ones,
+     * and run them all after unlocking.  A timer cancelled by an earlier
+     * callback in the same batch still runs this once.
+     */
+
+    std::vector<callback> due;
+    {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        std::int64_t now = nanotime();
+        while (! m_queue.empty() && m_queue.begin()->first <= now)
+        {
+            timer_id id = m_queue.begin()->second;
+            (void) m_queue.erase(m_queue.begin());
+            auto it = m_timers.find(id);
+            entry & e = it->second;
+            if (e.period > 0)
+            {
+                std::int64_t late = (now - e.deadline) / e.period;
+                m_missed += late;
+                e.deadline += (late + 1) * e.period;
+                (void) m_queue.insert(std::make_pair(e.deadline, id));
+                due.push_back(e.function);
+            }
+            else
+            {
+                due.push_back(std::move(e.function));
+                (void) m_timers.erase(it);
+            }
+        }
+        m_armed_ns = 0;
+        rearm();
+    }
+    for (auto & f : due)
+        f();
+
+    return int(due.size());
+}
+
+/**
+ *  Arms the timerfd for the earliest deadline, or disarms it.  The caller
+ *  holds the lock.
+ */
+
+void
+timer_service::rearm ()
+{
+    std::int64_t deadline = 0;
+    if (! m_queue.empty())
+    {
+        deadline = m_queue.begin()->first;
+        if (deadline < 1)
+            deadline = 1;                   /* 0 would disarm the timerfd   */
+    }
+
+    m_armed_ns = deadline;
+#if defined PLATFORM_LINUX
+    if (m_fd >= 0)
+    {
+        struct itimerspec spec;
+        spec.it_interval.tv_sec = 0;
+        spec.it_interval.tv_nsec = 0;
+        spec.it_value.tv_sec = time_t(deadline / 1000000000);
+        spec.it_value.tv_nsec = long(deadline % 1000000000);
+        (void) timerfd_settime(m_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+#endif
+}
+
+/**
+ *  Gets the earliest deadline, on the nanotime() scale, or 0 if there are
+ *  no timers.  This is for platforms without timerfd, or for an event loop
+ *  that computes its own poll() timeout.
+ */
+
+std::int64_t
+timer_service::next_deadline_ns () const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_queue.empty() ? 0 : m_queue.begin()->first ;
+}
+
+/**
+ *  Gets the number of pending timers.
+ */
+
+std::size_t
+timer_service::count () const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_timers.size();
+}
+
+/**
+ *  Gets the number of periodic deadlines skipped so far.
+ */
+
+std::int64_t
+timer_service::missed () const
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_missed;
+}
+
+}           // namespace xpc
+
+/*
+ * timerservice.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
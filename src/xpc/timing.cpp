@@ -21,13 +21,21 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2005-07-03 to 2007-08-21 (pre-Sequencer24/64/Seq66)
- * \updates       2024-01-17
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  Provides support for cross-platform time-related functions.
  */
 
+#include <algorithm>                    /* std::nth_element(), std::fill()  */
+#include <atomic>                       /* std::atomic<int>                 */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <mutex>                        /* std::call_once()                 */
+
 #include "platform_macros.h"            /* detects the build platform       */
+#include "xpc/cpu_hints.hpp"            /* xpc::cpu_relax()                 */
+#include "xpc/futex.hpp"                /* xpc::futex_wait()                */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_token                  */
 #include "xpc/timing.hpp"               /* xpc66::microsleep(), etc.        */
 
 #if defined PLATFORM_UNIX               // PLATFORM_LINUX
@@ -37,6 +45,9 @@
 #include <sched.h>                      /* sched_yield(), _get_priority()   */
 #include <stdio.h>                      /* snprintf()                       */
 #include <string.h>                     /* memset()                         */
+#if defined PLATFORM_LINUX
+#include <sys/prctl.h>                  /* prctl(), PR_SET_TIMERSLACK       */
+#endif
 #include <time.h>                       /* C::nanosleep(2)                  */
 #include <unistd.h>                     /* exit(), setsid()                 */
 
@@ -48,7 +59,7 @@
  */
 
 #include <windows.h>                    /* WaitForSingleObject(), INFINITE  */
-#include <mmsystem.h>                   /* Win32 timeGetTime() [!timeapi.h] */
+#include <mmsystem.h>                   /* timeBeginPeriod() [!timeapi.h]   */
 #include <synchapi.h>                   /* recent Windows "wait" functions  */
 
 #endif
@@ -129,6 +140,80 @@ millisleep (int ms)
     return result;
 }
 
+/**
+ *  Sleeps for a number of nanoseconds on a token's stop word, as a futex
+ *  wait, which stop_source::request_stop() wakes.  The time is 64-bit, so
+ *  that long millisecond sleeps do not overflow.
+ *
+ * \return
+ *      Returns true if the full sleep occurred, and false if a stop was
+ *      requested.
+ */
+
+static bool
+token_sleep_ns (std::atomic<int> & word, std::int64_t duration_ns)
+{
+    std::int64_t deadline = nanotime() + duration_ns;
+    for (;;)
+    {
+        std::int64_t ns = deadline - nanotime();
+        if (ns <= 0)
+            return true;
+
+        (void) futex_wait(word, 0, (long long) ns);
+        if (word.load() != 0)
+            return false;
+    }
+}
+
+/**
+ *  Sleeps like microsleep(), but wakes at once when a stop is requested on
+ *  the token.  A token with no source just sleeps.
+ *
+ * \param us
+ *      The number of microseconds to sleep.  Must be greater than 0.
+ *
+ * \param token
+ *      The stop token to watch.
+ *
+ * \return
+ *      Returns true if the full sleep occurred, and false if a stop was
+ *      requested (before or during the sleep) or "us" is not positive.
+ *      Hence the idiom "while (microsleep(period, token)) { work }".
+ */
+
+bool
+microsleep (int us, const stop_token & token)
+{
+    std::atomic<int> * word = token.stop_word();
+    if (word == nullptr)
+        return microsleep(us);
+
+    if (word->load() != 0 || us <= 0)
+        return false;
+
+    return token_sleep_ns(*word, std::int64_t(us) * 1000);
+}
+
+/**
+ *  The millisecond version of microsleep() with a stop token.  Any
+ *  positive "ms" is allowed; it is not converted to an int of
+ *  microseconds.
+ */
+
+bool
+millisleep (int ms, const stop_token & token)
+{
+    std::atomic<int> * word = token.stop_word();
+    if (word == nullptr)
+        return millisleep(ms);
+
+    if (word->load() != 0 || ms <= 0)
+        return false;
+
+    return token_sleep_ns(*word, std::int64_t(ms) * 1000000);
+}
+
 #if defined PLATFORM_UNIX               // PLATFORM_LINUX
 
 /**
@@ -245,105 +330,75 @@ thread_yield ()
 
 /*
  * --------------------------------------------------------------------------
- *  microtime() and millitime()
+ *  nanotime(), microtime(), and millitime()
  * --------------------------------------------------------------------------
  */
 
-#if defined PLATFORM_UNIX               // PLATFORM_LINUX
+#if defined PLATFORM_LINUX
 
 /**
- *  Gets the current system time in microseconds.
- *
- *  Should we try rounding off the nanoseconds here and in millitime()?
+ *  Gets the current monotonic time in nanoseconds.  This is the clock
+ *  that std::chrono::steady_clock reads in Linux, so values can be mixed
+ *  with steady_clock ones (see the helpers in timing.hpp).  It uses only
+ *  integer arithmetic, and a 64-bit result, which does not overflow for
+ *  292 years, even on 32-bit targets.
  */
 
-long
-microtime ()
+std::int64_t
+nanotime ()
 {
     struct timespec t;
     clock_gettime(CLOCK_MONOTONIC, &t);
-    return (t.tv_sec * 1000000) + (t.tv_nsec * 0.0010);
+    return std::int64_t(t.tv_sec) * 1000000000 + t.tv_nsec;
 }
 
+#else
+
 /**
- *  Gets the current system time in milliseconds.
- *
- * Better?
- *
- *  return (t.tv_sec * 1000) + ((t.tv_nsec + 500000) / 1000000);
+ *  Gets the current monotonic time in nanoseconds.  Elsewhere we simply
+ *  read std::chrono::steady_clock, which keeps the values compatible
+ *  with it.  (In macOS it is not CLOCK_MONOTONIC, and in Windows it is
+ *  QueryPerformanceCounter(), with the integer scaling done for us.  That
+ *  is far better than the old millitime() * 1000, with its 1 to 15 ms
+ *  resolution.)
  */
 
-long
-millitime ()
+std::int64_t
+nanotime ()
 {
-    struct timespec t;
-    clock_gettime(CLOCK_MONOTONIC, &t);
-    return (t.tv_sec * 1000) + (t.tv_nsec * 1.0e-6);
+    return std::int64_t
+    (
+        std::chrono::duration_cast<std::chrono::nanoseconds>
+        (
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count()
+    );
 }
 
-#elif defined PLATFORM_WINDOWS
+#endif
 
 /**
- *  Gets the current system time in microseconds.  Currently, we use
- *  millitime() and multiply by 1000, in effect what Seq32 does.
- *
- * GetSystemTimeAsFileTime:
- *
- *      It gives you accuracy in 0.1 microseconds or 100 nanoseconds.
- *
- *      Note that it's Epoch different from POSIX Epoch.
- *      So to get POSIX time in microseconds you need:
- *
-\verbatim
-            FILETIME ft;
-            GetSystemTimeAsFileTime(&ft);
-            unsigned long long tt = ft.dwHighDateTime;
-            tt <<=32;
-            tt |= ft.dwLowDateTime;
-            tt /=10;
-            tt -= 11644473600000000ULL;
-\endverbatim
- *
+ *  Gets the current monotonic time in microseconds.  It used to multiply
+ *  tv_nsec by 0.001, a floating-point conversion on every call, and to
+ *  return a long, which overflows 32 bits in about 36 minutes.
  */
 
-long
+std::int64_t
 microtime ()
 {
-#if defined PLATFORM_WINDOWS__THIS_CODE_IS_READY  // NOT!
-    FILETIME ft;
-    GetSystemTimeAsFileTime(&ft);
-    unsigned long long tt = ft.dwHighDateTime;
-    tt <<=32;
-    tt |= ft.dwLowDateTime;
-    tt /=10;
-    tt -= 11644473600000000ULL;
-    return tt;
-#else
-    return millitime() * 1000;
-#endif
+    return nanotime() / 1000;
 }
 
 /**
- *  Gets the current system time in milliseconds. Uses the Win32 function
- *  timeGetTime().
- *
- *  The default precision of timeGetTime() can be five milliseconds or more.
- *  One can use the timeBeginPeriod() and timeEndPeriod() functions to increase
- *  the precision of timeGetTime(). If done, the minimum difference between
- *  successive values returned by timeGetTime() can be as large as the minimum
- *  period value set using timeBeginPeriod() and timeEndPeriod(). Use
- *  QueryPerformanceCounter() and QueryPerformanceFrequency() to measure
- *  short time intervals at a high resolution.
+ *  Gets the current monotonic time in milliseconds, truncated.
  */
 
-long
+std::int64_t
 millitime ()
 {
-    return long(timeGetTime());
+    return nanotime() / 1000000;
 }
 
-#endif
-
 /*
  * --------------------------------------------------------------------------
  *  set_thread_priority() and set_timer_services()
@@ -356,6 +411,9 @@ millitime ()
  * In Linux, sets the thread priority for the calling thread, either the
  * performer input thread or output thread.
  *
+ * For the other policies, affinity, and settings that take effect before
+ * the thread body runs, see thread_attributes.
+ *
  * \param p
  *      This is the desired priority of the thread, ranging from 1 (low), to
  *      99 (high).  The default value is 1.
@@ -394,8 +452,92 @@ set_thread_priority (std::thread & t, int p)
     }
 }
 
+#if defined PLATFORM_LINUX
+
+/**
+ *  The calling thread's timer slack before set_timer_services(true), or
+ *  -1 if it has not been changed.  Each thread has its own slack, and so
+ *  its own saved value.
+ */
+
+static thread_local long tl_saved_slack_ns = -1;
+
+/**
+ *  In Linux, each sleep may be extended by up to the thread's "timer
+ *  slack", 50 us by default, so that the kernel can batch wakeups.  That
+ *  is the Linux counterpart of the Windows 1 ms timer period, so turning
+ *  the timer services on sets the calling thread's slack to 1 ns (the
+ *  smallest allowed), and turning them off restores the slack it had.
+ *  Call it from the thread that sleeps, e.g. the output thread.
+ *  (SCHED_FIFO and SCHED_RR threads get no slack anyway.)
+ *
+ * \param on
+ *      If true, saves the current slack and sets it to 1 ns.  If false,
+ *      restores the saved slack, if any.
+ *
+ * \return
+ *      Returns true if the prctl() calls succeeded.
+ */
+
+bool
+set_timer_services (bool on)
+{
+    bool result = true;
+    if (on)
+    {
+        long current = timer_slack_ns();
+        if (tl_saved_slack_ns < 0)
+            tl_saved_slack_ns = current;
+
+        result = set_timer_slack_ns(1);
+    }
+    else if (tl_saved_slack_ns >= 0)
+    {
+        result = set_timer_slack_ns(tl_saved_slack_ns);
+        tl_saved_slack_ns = -1;
+    }
+    return result;
+}
+
+/**
+ *  Gets the calling thread's timer slack.
+ *
+ * \return
+ *      Returns the slack in nanoseconds, or -1 on error.
+ */
+
+long
+timer_slack_ns ()
+{
+    int rc = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+    return long(rc);
+}
+
+/**
+ *  Sets the calling thread's timer slack.  Note that 0 means "the
+ *  process's default slack", not "no slack"; use 1 for the minimum.
+ *
+ * \param ns
+ *      The new slack, in nanoseconds.
+ *
+ * \return
+ *      Returns true if the call succeeded.
+ */
+
+bool
+set_timer_slack_ns (long ns)
+{
+    if (ns < 0)
+        return false;
+
+    return prctl(PR_SET_TIMERSLACK, (unsigned long) ns, 0, 0, 0) == 0;
+}
+
+#else
+
 /**
- *  Linux doesn't need this, so we just act like it works.
+ *  Other UNIXen have no timer slack to adjust, so we just act like it
+ *  works.
  */
 
 bool
@@ -404,6 +546,20 @@ set_timer_services (bool /*on*/)
     return true;
 }
 
+long
+timer_slack_ns ()
+{
+    return -1;
+}
+
+bool
+set_timer_slack_ns (long /*ns*/)
+{
+    return false;
+}
+
+#endif      // PLATFORM_LINUX
+
 #elif defined PLATFORM_WINDOWS
 
 /**
@@ -460,8 +616,309 @@ set_timer_services (bool on)
     return mmr == TIMERR_NOERROR;
 }
 
+/**
+ *  Windows has no per-thread timer slack; see set_timer_services().
+ */
+
+long
+timer_slack_ns ()
+{
+    return -1;
+}
+
+bool
+set_timer_slack_ns (long /*ns*/)
+{
+    return false;
+}
+
 #endif      // PLATFORM_LINUX, PLATFORM_WINDOWS
 
+/*
+ * --------------------------------------------------------------------------
+ *  Precise waits
+ * --------------------------------------------------------------------------
+ */
+
+/**
+ *  Sleeps (not spins) until the given nanotime() value.  A signal
+ *  interrupts the sleep, so we simply sleep again; with an absolute
+ *  deadline that costs no accuracy.  Where there is no clock_nanosleep()
+ *  (macOS, Windows), std::this_thread::sleep_until() on the steady clock
+ *  stands in; it is also absolute, just coarser.
+ *
+ * \param deadline_ns
+ *      The time to wake.  If it has passed, the call returns at once.
+ */
+
+void
+sleep_until_ns (std::int64_t deadline_ns)
+{
+#if defined PLATFORM_LINUX
+    struct timespec ts;
+    ts.tv_sec = time_t(deadline_ns / 1000000000LL);
+    ts.tv_nsec = long(deadline_ns % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+        // an absolute sleep can simply be restarted
+    }
+#else
+    std::this_thread::sleep_until(nanotime_to_time_point(deadline_ns));
+#endif
+}
+
+/*
+ *  A sleep wakes late by the timer slack plus the scheduling latency,
+ *  50 us or more with default settings.  A precise wait sleeps until a
+ *  "margin" before the deadline, then spins on the clock, with
+ *  cpu_relax(), for the rest.  Each thread keeps its own margin, since
+ *  the slack and the scheduling are per thread.  The margin is a high
+ *  percentile of the last c_precise_window sleep overshoots, plus a
+ *  little, so one bad wakeup widens it only until it leaves the window.
+ *  The calibration is done once per process; each new thread's window
+ *  starts out filled from it, and its own sleeps then replace it.
+ *  It is capped at c_precise_max_margin_us, and at a fraction of the time
+ *  left to the deadline, so that a short period still sleeps most of
+ *  the time instead of spinning all of it.
+ */
+
+namespace
+{
+
+/**
+ *  The sleep used for calibration, the number of samples, and the slack
+ *  added to the overshoot percentile.
+ */
+
+const int c_precise_probe_us        = 200;
+const int c_precise_samples         = 50;
+const int c_precise_pad_ns          = 5000;
+
+/**
+ *  The number of recent overshoots kept, and the percentile of them that
+ *  sets the margin.
+ */
+
+const int c_precise_window          = 64;
+const int c_precise_percentile      = 95;
+
+/**
+ *  The limits of the margin.  The upper limit bounds the spin, and so the
+ *  CPU cost, of each wait.  The spin is also at most 1/c_precise_divisor
+ *  of the time left when the wait starts.
+ */
+
+const int c_precise_min_margin_ns   = 5000;
+const int c_precise_max_margin_ns   = 1000000;
+const int c_precise_divisor         = 4;
+
+/**
+ *  The recent overshoots of the calling thread's sleeps, a ring, and the
+ *  margin they give.  A margin of zero means "not calibrated yet".
+ */
+
+struct precise_state
+{
+    int overshoots[c_precise_window];
+    int count;
+    int next;
+    int margin_ns;
+};
+
+thread_local precise_state tl_precise { {0}, 0, 0, 0 };
+
+/**
+ *  The margin from the last calibration in any thread, which seeds the
+ *  window of each thread that has not calibrated.  Zero means "none yet";
+ *  the first thread to need one calibrates, once.
+ */
+
+std::atomic<int> sg_precise_seed_ns { 0 };
+std::once_flag sg_precise_once;
+
+int
+clamp_margin (std::int64_t ns)
+{
+    if (ns < c_precise_min_margin_ns)
+        return c_precise_min_margin_ns;
+    else if (ns > c_precise_max_margin_ns)
+        return c_precise_max_margin_ns;
+    else
+        return int(ns);
+}
+
+/**
+ *  Adds an overshoot to the window and recomputes the margin from the
+ *  percentile of the window.  The window is small, so a copy and
+ *  nth_element() cost much less than the sleep that produced the sample.
+ */
+
+void
+record_overshoot (std::int64_t late_ns)
+{
+    precise_state & s = tl_precise;
+    if (late_ns < 0)
+        late_ns = 0;
+    else if (late_ns > c_precise_max_margin_ns)
+        late_ns = c_precise_max_margin_ns;
+
+    s.overshoots[s.next] = int(late_ns);
+    s.next = (s.next + 1) % c_precise_window;
+    if (s.count < c_precise_window)
+        ++s.count;
+
+    int sorted[c_precise_window];
+    std::copy(s.overshoots, s.overshoots + s.count, sorted);
+
+    int k = (s.count - 1) * c_precise_percentile / 100;
+    std::nth_element(sorted, sorted + k, sorted + s.count);
+    s.margin_ns = clamp_margin(std::int64_t(sorted[k]) + c_precise_pad_ns);
+}
+
+/**
+ *  Fills the calling thread's window with the overshoot that gives the
+ *  process-wide margin, so that the thread starts with that margin and its
+ *  own sleeps replace the seed one by one.
+ */
+
+void
+seed_precise_state (int margin_ns)
+{
+    precise_state & s = tl_precise;
+    int late_ns = margin_ns - c_precise_pad_ns;
+    if (late_ns < 0)
+        late_ns = 0;
+
+    std::fill(s.overshoots, s.overshoots + c_precise_window, late_ns);
+    s.count = c_precise_window;
+    s.next = 0;
+    s.margin_ns = margin_ns;
+}
+
+/**
+ *  Gets the calling thread's margin.  On the thread's first use it is
+ *  seeded from the process-wide calibration, which is done here if no
+ *  thread has done it yet.
+ */
+
+int
+precise_margin_ns ()
+{
+    if (tl_precise.margin_ns == 0)
+    {
+        if (sg_precise_seed_ns.load() == 0)
+        {
+            std::call_once
+            (
+                sg_precise_once, [] { (void) calibrate_precise_sleep(); }
+            );
+        }
+        if (tl_precise.margin_ns == 0)
+            seed_precise_state(sg_precise_seed_ns.load());
+    }
+    return tl_precise.margin_ns;
+}
+
+}           // anonymous namespace
+
+/**
+ *  Measures how late short sleeps wake up on this machine, in the calling
+ *  thread, and sets that thread's margin for the precise waits.  It takes
+ *  about c_precise_samples * c_precise_probe_us (10 ms).  The result also
+ *  seeds the margin of every thread that starts precise waits later, so a
+ *  program calls it once at startup, and real-time threads do not pay for
+ *  it on their first wait.  If no thread has called it, the first precise
+ *  wait in the process does.  Call it again after changing a thread's
+ *  scheduling or timer slack, from that thread.  The samples replace the
+ *  thread's window of recent overshoots.
+ *
+ * \return
+ *      Returns the new margin in microseconds (rounded up).
+ */
+
+int
+calibrate_precise_sleep ()
+{
+    tl_precise.count = tl_precise.next = 0;
+    for (int i = 0; i < c_precise_samples; ++i)
+    {
+        std::int64_t deadline = nanotime() + c_precise_probe_us * 1000LL;
+        sleep_until_ns(deadline);
+        record_overshoot(nanotime() - deadline);
+    }
+    sg_precise_seed_ns.store(tl_precise.margin_ns);
+    return (tl_precise.margin_ns + 999) / 1000;
+}
+
+/**
+ *  Gets the calling thread's current margin, the most of each precise
+ *  wait that is spent spinning, in microseconds (rounded up).
+ */
+
+int
+precise_margin_us ()
+{
+    return (precise_margin_ns() + 999) / 1000;
+}
+
+/**
+ *  Waits until a nanotime() value, sleeping until the margin and spinning
+ *  the rest.  Every sleep's overshoot updates the calling thread's margin.
+ *
+ * \param deadline_ns
+ *      The deadline.  If it has passed, the call returns false at once.
+ *
+ * \return
+ *      Returns true if the deadline was met within the spin, and false if
+ *      it had already passed or the sleep overshot it.
+ */
+
+bool
+precise_sleep_until_ns (std::int64_t deadline_ns)
+{
+    std::int64_t margin = precise_margin_ns();
+    std::int64_t now = nanotime();
+    if (deadline_ns <= now)
+        return false;
+
+    std::int64_t cap = (deadline_ns - now) / c_precise_divisor;
+    if (margin > cap)
+        margin = cap;
+
+    std::int64_t wake = deadline_ns - margin;
+    if (wake > now)
+    {
+        sleep_until_ns(wake);
+        now = nanotime();
+        record_overshoot(now - wake);
+        if (now > deadline_ns)
+            return false;
+    }
+    while (nanotime() < deadline_ns)
+        cpu_relax();
+
+    return true;
+}
+
+/**
+ *  The relative version of precise_sleep_until_ns().
+ *
+ * \param us
+ *      The number of microseconds to wait.  Must be greater than 0.
+ *
+ * \return
+ *      Returns false if "us" is not positive or the deadline was missed.
+ */
+
+bool
+precise_microsleep (int us)
+{
+    if (us <= 0)
+        return false;
+
+    return precise_sleep_until_ns(nanotime() + us * 1000LL);
+}
+
 }           // namespace xpc
 
 /*
@@ -0,0 +1,338 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timingwheel.cpp
+ *
+ *  This module defines the timing_wheel class.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  A timer due in tick E, filed while the next tick to process is C, goes
+ *  in the lowest level L for which E - C < 256^(L+1), in slot
+ *  (E >> 8L) & 255.  Processing tick C:
+ *
+ *      -#  If C's level-0 index is 0, level 0 has wrapped, so the level-1
+ *          slot for C is refiled.  Only if its level-1 index is also 0 is
+ *          the level-2 slot for C refiled next, and so on up.  Refiled
+ *          timers land in lower levels, since they are now nearer; none
+ *          lands in a slot already cascaded for C, since a timer due
+ *          within 256^L ticks of C is filed below level L.
+ *      -#  The level-0 slot for C moves to the expiring list, and each
+ *          timer on it is freed and its callback run.
+ *
+ *  A tick is processed once nanotime() reaches its start, and a timer is
+ *  filed in the first tick that starts at or after its deadline, so a
+ *  callback never runs early; it runs up to one tick (plus the advance()
+ *  period) late.
+ */
+
+#include "xpc/timing.hpp"               /* xpc::nanotime()                  */
+#include "xpc/timingwheel.hpp"          /* xpc::timing_wheel                */
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+/**
+ * \param capacity
+ *      The most timers that can be scheduled at once.  All of them are
+ *      allocated here.
+ *
+ * \param tick_us
+ *      The tick length, which is the resolution of the timers.  The
+ *      default is 1 ms.
+ */
+
+timing_wheel::timing_wheel (std::size_t capacity, int tick_us) :
+    m_pool      (capacity),
+    m_heads     (c_list_count, -1),
+    m_tick_ns   (std::int64_t(tick_us > 0 ? tick_us : 1) * 1000),
+    m_start_ns  (nanotime()),
+    m_current   (0),
+    m_pending   (0)
+{
+    for (std::size_t i = capacity; i > 0; --i)
+    {
+        node & n = m_pool[i - 1];
+        n.list = -1;
+        n.generation = 1;
+        n.expires = 0;
+        n.function = nullptr;
+        n.data = nullptr;
+        link(std::int32_t(i - 1), c_free_list);
+    }
+}
+
+/**
+ *  Puts a node at the front of a list.
+ */
+
+void
+timing_wheel::link (std::int32_t index, int list)
+{
+    node & n = m_pool[index];
+    n.list = list;
+    n.prev = -1;
+    n.next = m_heads[list];
+    if (n.next >= 0)
+        m_pool[n.next].prev = index;
+
+    m_heads[list] = index;
+}
+
+/**
+ *  Takes a node out of whatever list it is in.
+ */
+
+void
+timing_wheel::unlink (std::int32_t index)
+{
+    node & n = m_pool[index];
+    if (n.prev >= 0)
+        m_pool[n.prev].next = n.next;
+    else
+        m_heads[n.list] = n.next;
+
+    if (n.next >= 0)
+        m_pool[n.next].prev = n.prev;
+
+    n.list = n.prev = n.next = -1;
+}
+
+/**
+ *  Files a scheduled node in the slot for its expiry tick.
+ */
+
+void
+timing_wheel::file (std::int32_t index)
+{
+    node & n = m_pool[index];
+    std::uint64_t e = n.expires;
+    if (e < m_current)
+        e = n.expires = m_current;
+
+    std::uint64_t delta = e - m_current;
+    int level = 0;
+    while (level < c_levels - 1 &&
+        delta >= (std::uint64_t(1) << (c_level_bits * (level + 1))))
+    {
+        ++level;
+    }
+    int slot = int((e >> (c_level_bits * level)) & (c_slots - 1));
+    link(index, level * c_slots + slot);
+}
+
+/**
+ *  Refiles the timers of one slot of an upper level.
+ *
+ * \return
+ *      Returns the slot number, so the caller can tell if this level
+ *      wrapped too.
+ */
+
+int
+timing_wheel::cascade (int level, int slot)
+{
+    int list = level * c_slots + slot;
+    std::int32_t index = m_heads[list];
+    m_heads[list] = -1;
+    while (index >= 0)
+    {
+        std::int32_t next = m_pool[index].next;
+        file(index);
+        index = next;
+    }
+    return slot;
+}
+
+/**
+ *  Schedules a callback after a delay.
+ *
+ * \param delay_us
+ *      The delay in microseconds from now.
+ *
+ * \param f
+ *      The function to call.  It must not be null.
+ *
+ * \param data
+ *      The pointer to pass to it.
+ *
+ * \return
+ *      Returns the id for cancel(), or 0 if all of the timers are in use.
+ */
+
+timing_wheel::timer_id
+timing_wheel::schedule (std::int64_t delay_us, callback f, void * data)
+{
+    return schedule_at(nanotime() + delay_us * 1000, f, data);
+}
+
+/**
+ *  Schedules a callback at a nanotime() deadline.  The delay is limited to
+ *  256^4 ticks; longer ones are shortened to that.
+ */
+
+timing_wheel::timer_id
+timing_wheel::schedule_at (std::int64_t deadline_ns, callback f, void * data)
+{
+    std::int32_t index = m_heads[c_free_list];
+    if (index < 0 || f == nullptr)
+        return 0;
+
+    unlink(index);
+    node & n = m_pool[index];
+    std::int64_t since = deadline_ns - m_start_ns;
+    std::uint64_t tick = since > 0 ?
+        std::uint64_t((since + m_tick_ns - 1) / m_tick_ns) : 0 ;
+
+    std::uint64_t limit = m_current +
+        ((std::uint64_t(1) << (c_level_bits * c_levels)) - 1);
+
+    n.expires = tick < limit ? tick : limit ;
+    n.function = f;
+    n.data = data;
+    file(index);
+    ++m_pending;
+    return (timer_id(n.generation) << 32) | timer_id(index + 1);
+}
+
+/**
+ *  Cancels a timer.  O(1).
+ *
+ * \return
+ *      Returns true if the timer was pending; false if it had already run,
+ *      been cancelled, or the id is invalid.
+ */
+
+bool
+timing_wheel::cancel (timer_id id)
+{
+    std::uint64_t slot = id & 0xFFFFFFFFu;
+    if (slot == 0 || slot > m_pool.size())
+        return false;
+
+    std::int32_t index = std::int32_t(slot - 1);
+    node & n = m_pool[index];
+    if (n.generation != std::uint32_t(id >> 32) || n.list < 0 ||
+        n.list == c_free_list)
+    {
+        return false;
+    }
+    unlink(index);
+    ++n.generation;
+    n.function = nullptr;
+    link(index, c_free_list);
+    --m_pending;
+    return true;
+}
+
+/**
+ *  Processes all ticks up to the current time, running the callbacks of
+ *  the timers that are due.
+ *
+ * \return
+ *      Returns the number of callbacks run.
+ */
+
+int
+timing_wheel::advance ()
+{
+    return advance(nanotime());
+}
+
+int
+timing_wheel::advance (std::int64_t now_ns)
+{
+    std::int64_t since = now_ns - m_start_ns;
+    if (since < 0)
+        return 0;
+
+    std::uint64_t target = std::uint64_t(since / m_tick_ns);
+    if (m_pending == 0)
+    {
+        if (target >= m_current)
+            m_current = target + 1;             /* nothing to cascade       */
+
+        return 0;
+    }
+
+    int fired = 0;
+    while (m_current <= target)
+    {
+        int index = int(m_current & (c_slots - 1));
+        if (index == 0)
+        {
+            for (int level = 1; level < c_levels; ++level)
+            {
+                int slot = int
+                (
+                    (m_current >> (c_level_bits * level)) & (c_slots - 1)
+                );
+                if (cascade(level, slot) != 0)
+                    break;
+            }
+        }
+        ++m_current;
+
+        /*
+         * Move the whole slot to the expiring list, then run it, so that
+         * callbacks that schedule new timers do not touch this batch.
+         */
+
+        m_heads[c_expiring_list] = m_heads[index];
+        m_heads[index] = -1;
+        for (std::int32_t i = m_heads[c_expiring_list]; i >= 0; )
+        {
+            m_pool[i].list = c_expiring_list;
+            i = m_pool[i].next;
+        }
+        while (m_heads[c_expiring_list] >= 0)
+        {
+            std::int32_t i = m_heads[c_expiring_list];
+            node & n = m_pool[i];
+            callback f = n.function;
+            void * data = n.data;
+            unlink(i);
+            ++n.generation;
+            n.function = nullptr;
+            link(i, c_free_list);
+            --m_pending;
+            ++fired;
+            f(data);
+        }
+        if (m_pending == 0 && m_current <= target)
+            m_current = target + 1;
+    }
+    return fired;
+}
+
+}           // namespace xpc
+
+/*
+ * timingwheel.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -25,7 +25,7 @@
  * \library       xpc66
  * \author        Chris Ahlstrom
  * \date          2024-04-15
- * \updates       2024-04-17
+ * \updates       2026-10-18
  * \license       GNU GPLv2 or above
  *
  *  Near duplicates of a few functions from the cfg66 library, defined here
@@ -407,7 +407,11 @@ normalize_path (const std::string & path, bool to_unix, bool terminate)
 }
 
 /**
- *  Gets the current date/time.
+ *  Gets the current date/time.  The text only changes once a second, so
+ *  each thread caches it, and redoes the local-time conversion and the
+ *  formatting only when the second changes.  Caching per thread also
+ *  makes the function thread-safe, which the shared static buffer and
+ *  localtime() were not.  time() itself is a cheap, coarse clock read.
  *
  * \return
  *      Returns the current date and time as a string.
@@ -416,15 +420,25 @@ normalize_path (const std::string & path, bool to_unix, bool terminate)
 std::string
 current_date_time ()
 {
-    static char s_temp[64];
     static const char * const s_format = "%Y-%m-%d %H:%M:%S";
-    time_t t;
-    std::memset(s_temp, 0, sizeof s_temp);
-    time(&t);
+    static thread_local time_t tl_last = time_t(-1);
+    static thread_local char tl_text[64];
+    time_t t = time(NULL);
+    if (t != tl_last)
+    {
+#if defined PLATFORM_WINDOWS
+        struct tm * tm = localtime(&t);         /* thread-local in the CRT  */
+#else
+        struct tm tmbuffer;
+        struct tm * tm = localtime_r(&t, &tmbuffer);
+#endif
+        std::memset(tl_text, 0, sizeof tl_text);
+        if (not_nullptr(tm))
+            std::strftime(tl_text, sizeof tl_text - 1, s_format, tm);
 
-    struct tm * tm = localtime(&t);
-    std::strftime(s_temp, sizeof s_temp - 1, s_format, tm);
-    return std::string(s_temp);
+        tl_last = t;
+    }
+    return std::string(tl_text);
 }
 
 /**
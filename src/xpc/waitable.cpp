@@ -0,0 +1,180 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          waitable.cpp
+ *
+ *  This module defines wait_any().
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       GNU GPLv2 or above
+ *
+ *  A poll() interrupted by a signal is restarted with the time remaining,
+ *  so that a signal handler (the session handler, say) does not cut a wait
+ *  short.  If the signal made an object ready, the restarted poll() sees it
+ *  at once.
+ */
+
+#include "platform_macros.h"            /* PLATFORM_UNIX                    */
+#include "xpc/waitable.hpp"             /* xpc::waitable, xpc::wait_any()   */
+
+#include <cerrno>                       /* errno, EINTR, EBADF, etc.        */
+
+#if defined PLATFORM_UNIX
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <poll.h>                       /* poll(), struct pollfd            */
+#include <vector>                       /* std::vector<>                    */
+#endif
+
+/*
+ *  Do not document a namespace; it breaks Doxygen.
+ */
+
+namespace xpc
+{
+
+#if defined PLATFORM_UNIX
+
+/**
+ *  The most objects that wait_any() handles without allocating.
+ */
+
+static const int c_max_local_objects = 8;
+
+/**
+ *  Waits until one of the objects is ready, or the timeout passes.
+ *
+ * \param objects
+ *      The objects to wait on.  Null pointers, and objects with no
+ *      descriptor, are never ready.  If none has a descriptor, there is
+ *      nothing to wait for, and the call fails at once (errno EBADF),
+ *      whatever the timeout; it is not a sleep.
+ *
+ * \param count
+ *      The number of objects.
+ *
+ * \param timeout_ms
+ *      The longest wait, in milliseconds.  Negative means no limit, and 0
+ *      just checks.
+ *
+ * \return
+ *      Returns the index of the first ready object (the lowest index if
+ *      several are ready), or -1 on timeout or error.  A descriptor that
+ *      poll() reports as invalid, in error, or hung up (POLLNVAL, POLLERR,
+ *      POLLHUP without POLLIN) is an error, not a wakeup.  errno is
+ *      ETIMEDOUT for a timeout, and otherwise tells the error.
+ */
+
+int
+wait_any (const waitable * const * objects, int count, int timeout_ms)
+{
+    pollfd local[c_max_local_objects];
+    std::vector<pollfd> heap;
+    pollfd * fds = local;
+    if (count > c_max_local_objects)
+    {
+        heap.resize(std::size_t(count));
+        fds = heap.data();
+    }
+    int valid = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        fds[i].fd = objects[i] != nullptr ? objects[i]->wait_fd() : -1 ;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+        if (fds[i].fd >= 0)
+            ++valid;
+    }
+    if (valid == 0)
+    {
+        errno = EBADF;                  /* poll() would wait for nothing    */
+        return -1;
+    }
+
+    using clock = std::chrono::steady_clock;
+    clock::time_point deadline;
+    if (timeout_ms > 0)
+        deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    int remaining = timeout_ms;
+    for (;;)
+    {
+        int rc = poll(fds, nfds_t(count), remaining);
+        if (rc > 0)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                short r = fds[i].revents;
+                if ((r & POLLIN) != 0)
+                    return i;
+
+                if (r != 0)
+                {
+                    errno = (r & POLLNVAL) != 0 ? EBADF : EIO ;
+                    return -1;
+                }
+            }
+            errno = EIO;
+            return -1;
+        }
+        if (rc == 0)
+        {
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        if (errno != EINTR)
+            return -1;
+
+        if (timeout_ms > 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>
+            (
+                deadline - clock::now()
+            ).count();
+            remaining = left > 0 ? int(left) : 0 ;
+        }
+    }
+}
+
+#else       // ! defined PLATFORM_UNIX
+
+int
+wait_any (const waitable * const *, int, int)
+{
+    errno = ENOTSUP;
+    return -1;                          /* not supported                    */
+}
+
+#endif      // defined PLATFORM_UNIX
+
+int
+wait_any (std::initializer_list<const waitable *> objects, int timeout_ms)
+{
+    return wait_any(objects.begin(), int(objects.size()), timeout_ms);
+}
+
+}           // namespace xpc
+
+/*
+ * waitable.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,183 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          barrier_test.cpp
+ *
+ *      Tests of xpc::barrier and xpc::latch.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Barrier: over many phases, the completion function runs once per phase,
+ *  after every thread has arrived and before any is released, and exactly
+ *  one thread per phase gets true from arrive_and_wait().
+ *
+ *  Latch: no waiter is released before the count reaches zero, then every
+ *  waiter is released, once; a wait on an open latch returns at once.
+ */
+
+#include <atomic>                       /* std::atomic<int>                 */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/barrier.hpp"              /* xpc::barrier, xpc::latch         */
+#include "xpc/timing.hpp"               /* xpc::millisleep()                */
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+static void
+test_barrier ()
+{
+    const int threads = 4;
+    const int phases = 500;
+    std::atomic<int> arrived { 0 };
+    int completions = 0;                /* written only by the completion   */
+    bool complete_early = false;
+    xpc::barrier b
+    (
+        threads,
+        [&arrived, &completions, &complete_early] ()
+        {
+            ++completions;
+            if (arrived.load() != completions * threads)
+                complete_early = true;
+        }
+    );
+
+    std::atomic<int> serial { 0 };
+    std::atomic<int> released_early { 0 };
+    std::atomic<int> stale { 0 };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back
+        (
+            [&] ()
+            {
+                for (int p = 0; p < phases; ++p)
+                {
+                    if (completions != p)
+                        ++stale;
+
+                    ++arrived;
+                    if (b.arrive_and_wait())
+                        ++serial;
+
+                    if (completions != p + 1)
+                        ++released_early;
+                }
+            }
+        );
+    }
+    for (auto & t : workers)
+        t.join();
+
+    check(completions == phases, "barrier: completion runs once per phase");
+    check(! complete_early, "barrier: ... after every thread arrives");
+    check(released_early == 0, "barrier: ... before any is released");
+    check(stale == 0, "barrier: ... and not again until the next phase");
+    check(serial == phases, "barrier: one true return per phase");
+    check(b.phase() == phases, "barrier: phase() counts the phases");
+}
+
+static void
+test_latch ()
+{
+    const int waiters = 4;
+    xpc::latch gate(3);
+    std::atomic<int> released { 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < waiters; ++i)
+    {
+        threads.emplace_back
+        (
+            [&gate, &released] ()
+            {
+                gate.wait();
+                ++released;
+            }
+        );
+    }
+    check(! gate.try_wait(), "latch: starts closed");
+    gate.count_down();
+    gate.count_down();
+    (void) xpc::millisleep(50);
+    check(released == 0, "latch: no waiter released before zero");
+    gate.count_down();
+    for (auto & t : threads)
+        t.join();
+
+    check(released == waiters, "latch: every waiter released, once");
+    check(gate.try_wait(), "latch: stays open");
+    gate.wait();
+    gate.count_down();
+    check(gate.try_wait(), "latch: counting past zero keeps it open");
+
+    xpc::latch pair(2);
+    std::atomic<int> through { 0 };
+    std::thread other
+    (
+        [&pair, &through] ()
+        {
+            pair.arrive_and_wait();
+            ++through;
+        }
+    );
+    (void) xpc::millisleep(20);
+    check(through == 0, "latch: arrive_and_wait() waits for the others");
+    pair.arrive_and_wait();
+    other.join();
+    check(through == 1, "latch: ... and is released by the last");
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    test_barrier();
+    test_latch();
+    if (s_failures == 0)
+        std::printf("barrier_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * barrier_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
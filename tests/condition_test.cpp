@@ -0,0 +1,203 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          condition_test.cpp
+ *
+ *      Tests of xpc::condition.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Separate: each condition has its own condition variable, so a signal()
+ *  or broadcast() on one condition does not wake a thread waiting on
+ *  another, and a signal() on the right one does.
+ *
+ *  Timed: wait(ms) and wait_until() really wait, for at least the time
+ *  given as measured by the monotonic clock (nanotime()), and then return
+ *  true for the timeout.  A wait of 0 ms, or to a deadline already past,
+ *  returns true at once.
+ */
+
+#include <atomic>                       /* std::atomic<bool>                */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdint>                      /* std::int64_t                     */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <thread>                       /* std::thread                      */
+
+#include "xpc/condition.hpp"            /* xpc::condition                   */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), millisleep()    */
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+/**
+ *  A thread that waits once on a condition, with a time limit, and
+ *  records whether the wait timed out.
+ */
+
+struct waiter
+{
+    xpc::condition & cond;
+    bool waiting;
+    std::atomic<bool> done;
+    bool timed_out;
+    std::thread thread;
+
+    waiter (xpc::condition & c, int ms) :
+        cond        (c),
+        waiting     (false),
+        done        (false),
+        timed_out   (false),
+        thread      ()
+    {
+        thread = std::thread
+        (
+            [this, ms] ()
+            {
+                cond.lock();
+                waiting = true;
+                timed_out = cond.wait(ms);
+                cond.unlock();
+                done = true;
+            }
+        );
+    }
+
+    /**
+     *  Returns once the thread is inside its wait: it set the flag while
+     *  holding the lock, which the wait releases.
+     */
+
+    void wait_for_wait ()
+    {
+        for (;;)
+        {
+            cond.lock();
+            bool w = waiting;
+            cond.unlock();
+            if (w)
+                break;
+
+            (void) xpc::millisleep(1);
+        }
+    }
+};
+
+static void
+test_separate ()
+{
+    xpc::condition a;
+    xpc::condition b;
+    waiter on_a(a, 300);
+    on_a.wait_for_wait();
+
+    b.lock();
+    b.signal();
+    b.broadcast();
+    b.unlock();
+    (void) xpc::millisleep(50);
+    check(! on_a.done, "separate: signals on b do not wake a waiter on a");
+    on_a.thread.join();
+    check(on_a.timed_out, "separate: ... which times out");
+
+    waiter second(a, 5000);
+    second.wait_for_wait();
+    std::int64_t t0 = xpc::nanotime();
+    a.lock();
+    a.signal();
+    a.unlock();
+    second.thread.join();
+    check(! second.timed_out, "separate: a signal on a wakes it");
+    check
+    (
+        xpc::nanotime() - t0 < 1000000000,
+        "separate: ... at once, not at the time limit"
+    );
+}
+
+static void
+test_timed ()
+{
+    xpc::condition c;
+    c.lock();
+    std::int64_t t0 = xpc::nanotime();
+    bool timed_out = c.wait(30);
+    std::int64_t waited = xpc::nanotime() - t0;
+    check(timed_out, "timed: wait(30) times out");
+    check(waited >= 30000000, "timed: wait(30) waits 30 ms or more");
+    check(waited < 1000000000, "timed: ... and not much more");
+
+    t0 = xpc::nanotime();
+    timed_out = c.wait(0);
+    waited = xpc::nanotime() - t0;
+    check(timed_out && waited < 10000000, "timed: wait(0) does not wait");
+
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(20);
+    timed_out = c.wait_until(deadline);
+    check(timed_out, "timed: wait_until() times out");
+    check
+    (
+        std::chrono::steady_clock::now() >= deadline,
+        "timed: wait_until() does not return before the deadline"
+    );
+    t0 = xpc::nanotime();
+    timed_out = c.wait_until(start);
+    waited = xpc::nanotime() - t0;
+    check
+    (
+        timed_out && waited < 10000000,
+        "timed: wait_until() a past deadline does not wait"
+    );
+    c.unlock();
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    test_separate();
+    test_timed();
+    if (s_failures == 0)
+        std::printf("condition_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * condition_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
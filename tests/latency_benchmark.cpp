@@ -0,0 +1,522 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          latency_benchmark.cpp
+ *
+ *      A wakeup-latency benchmark, in the manner of cyclictest, for
+ *      qualifying a host for real-time use with the xpc66 timers.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Usage:
+ *
+ *      latency_benchmark [ -m sleep | periodic | precise ] [ -t threads ]
+ *          [ -p priority ] [ -i interval-us ] [ -l loops ]
+ *          [ -b histogram-us ] [ -j file.json | - ]
+ *
+ *  Each thread wakes up "loops" times, every "interval" microseconds, and
+ *  records how late it woke, in nanoseconds, against the intended time:
+ *
+ *      -   sleep:  microsleep(interval); the intended time is the time
+ *          before the call plus the interval.
+ *      -   periodic:  periodic_timer::wait(); the intended time is the
+ *          deadline being waited for.
+ *      -   precise:  precise_sleep_until_ns() on a fixed schedule.
+ *
+ *  The threads are given the SCHED_FIFO priority with
+ *  set_thread_priority() (0, the default, leaves them alone; real-time
+ *  priorities need privileges), and each calls set_timer_services(true)
+ *  before it starts.  A latch holds them all until the priorities are
+ *  set.
+ *
+ *  The latencies go into a histogram of 1 us buckets up to the
+ *  "histogram-us" limit (default 1000), with a count of overflows.  For
+ *  each thread, and for all of them, the program prints the minimum,
+ *  average, 99th and 99.99th percentile, and maximum, in microseconds.
+ *  The percentiles are the upper edges of their buckets; if one falls in
+ *  the overflow, it is reported as the maximum.  With -j, the same figures
+ *  and the non-empty buckets are written as JSON to the file (or to
+ *  standard output for "-"), for scripts that gate kernel and BIOS
+ *  changes on them.
+ */
+
+#include <cmath>                        /* std::ceil()                      */
+#include <cstdio>                       /* std::printf(), std::fopen()      */
+#include <cstdlib>                      /* EXIT_SUCCESS, std::atoi()        */
+#include <cstdint>                      /* std::int64_t, std::uint64_t      */
+#include <cstring>                      /* std::strcmp()                    */
+#include <functional>                   /* std::ref(), std::cref()          */
+#include <limits>                       /* std::numeric_limits<>            */
+#include <string>                       /* std::string, std::to_string()    */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/barrier.hpp"              /* xpc::latch                       */
+#include "xpc/periodictimer.hpp"        /* xpc::periodic_timer              */
+#include "xpc/timing.hpp"               /* xpc::microsleep(), nanotime()    */
+
+/*
+ *  The wakeup methods.
+ */
+
+enum class mode
+{
+    sleep,
+    periodic,
+    precise
+};
+
+static const char *
+mode_name (mode m)
+{
+    return m == mode::sleep ? "sleep" :
+        m == mode::periodic ? "periodic" : "precise" ;
+}
+
+/*
+ *  The settings, from the command line.
+ */
+
+struct settings
+{
+    mode method;
+    int threads;
+    int priority;
+    int interval_us;
+    int loops;
+    int histogram_us;
+    std::string json;
+};
+
+/**
+ *  A latency histogram, with 1 us buckets, and the exact extremes.
+ */
+
+class histogram
+{
+
+private:
+
+    std::vector<std::uint64_t> m_buckets;
+    std::uint64_t m_overflows;
+    std::uint64_t m_count;
+    std::int64_t m_min_ns;
+    std::int64_t m_max_ns;
+    double m_sum_ns;
+
+public:
+
+    explicit histogram (int buckets) :
+        m_buckets   (std::size_t(buckets), 0),
+        m_overflows (0),
+        m_count     (0),
+        m_min_ns    (std::numeric_limits<std::int64_t>::max()),
+        m_max_ns    (0),
+        m_sum_ns    (0.0)
+    {
+        // no code
+    }
+
+    /**
+     *  Records one latency.  An early wakeup, which should not happen,
+     *  counts as zero.
+     */
+
+    void add (std::int64_t ns)
+    {
+        if (ns < 0)
+            ns = 0;
+
+        std::size_t bucket = std::size_t(ns / 1000);
+        if (bucket < m_buckets.size())
+            ++m_buckets[bucket];
+        else
+            ++m_overflows;
+
+        if (ns < m_min_ns)
+            m_min_ns = ns;
+
+        if (ns > m_max_ns)
+            m_max_ns = ns;
+
+        m_sum_ns += double(ns);
+        ++m_count;
+    }
+
+    void merge (const histogram & h)
+    {
+        for (std::size_t i = 0; i < m_buckets.size(); ++i)
+            m_buckets[i] += h.m_buckets[i];
+
+        m_overflows += h.m_overflows;
+        m_count += h.m_count;
+        m_sum_ns += h.m_sum_ns;
+        if (h.m_min_ns < m_min_ns)
+            m_min_ns = h.m_min_ns;
+
+        if (h.m_max_ns > m_max_ns)
+            m_max_ns = h.m_max_ns;
+    }
+
+    std::uint64_t count () const
+    {
+        return m_count;
+    }
+
+    std::uint64_t overflows () const
+    {
+        return m_overflows;
+    }
+
+    const std::vector<std::uint64_t> & buckets () const
+    {
+        return m_buckets;
+    }
+
+    double min_us () const
+    {
+        return m_count > 0 ? m_min_ns / 1000.0 : 0.0 ;
+    }
+
+    double max_us () const
+    {
+        return m_max_ns / 1000.0;
+    }
+
+    double avg_us () const
+    {
+        return m_count > 0 ? m_sum_ns / m_count / 1000.0 : 0.0 ;
+    }
+
+    /**
+     *  Gets the upper edge of the bucket holding the given fraction of the
+     *  samples, or the maximum if it is in the overflow.
+     */
+
+    double percentile_us (double fraction) const
+    {
+        if (m_count == 0)
+            return 0.0;
+
+        std::uint64_t target = std::uint64_t                /* nearest rank */
+        (
+            std::ceil(fraction * double(m_count))
+        );
+        if (target == 0)
+            target = 1;
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < m_buckets.size(); ++i)
+        {
+            seen += m_buckets[i];
+            if (seen >= target)
+                return double(i + 1) < max_us() ? double(i + 1) : max_us() ;
+        }
+        return max_us();
+    }
+
+};          // class histogram
+
+/**
+ *  The body of one measuring thread.
+ */
+
+static void
+measure (const settings & s, xpc::latch & start, histogram & h)
+{
+    (void) xpc::set_timer_services(true);
+    start.wait();
+
+    const std::int64_t interval_ns = std::int64_t(s.interval_us) * 1000;
+    if (s.method == mode::sleep)
+    {
+        for (int i = 0; i < s.loops; ++i)
+        {
+            std::int64_t intended = xpc::nanotime() + interval_ns;
+            (void) xpc::microsleep(s.interval_us);
+            h.add(xpc::nanotime() - intended);
+        }
+    }
+    else if (s.method == mode::periodic)
+    {
+        xpc::periodic_timer timer(s.interval_us);
+        timer.start();
+        for (int i = 0; i < s.loops; ++i)
+        {
+            std::int64_t intended = timer.next_deadline_ns();
+            (void) timer.wait();
+            h.add(xpc::nanotime() - intended);
+        }
+    }
+    else
+    {
+        std::int64_t intended = xpc::nanotime();
+        for (int i = 0; i < s.loops; ++i)
+        {
+            intended += interval_ns;
+            (void) xpc::precise_sleep_until_ns(intended);
+            std::int64_t now = xpc::nanotime();
+            h.add(now - intended);
+            if (now - intended > interval_ns)
+                intended = now;                 /* do not try to catch up   */
+        }
+    }
+    (void) xpc::set_timer_services(false);
+}
+
+static void
+print_row (const char * name, const histogram & h)
+{
+    std::printf
+    (
+        "%8s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %9llu\n",
+        name, (unsigned long long) h.count(), h.min_us(), h.avg_us(),
+        h.percentile_us(0.99), h.percentile_us(0.9999), h.max_us(),
+        (unsigned long long) h.overflows()
+    );
+}
+
+static void
+write_stats (std::FILE * f, const histogram & h, const char * indent)
+{
+    std::fprintf
+    (
+        f,
+        "%s\"samples\": %llu,\n"
+        "%s\"min_us\": %.3f,\n"
+        "%s\"avg_us\": %.3f,\n"
+        "%s\"p99_us\": %.3f,\n"
+        "%s\"p9999_us\": %.3f,\n"
+        "%s\"max_us\": %.3f,\n"
+        "%s\"overflows\": %llu,\n"
+        "%s\"histogram\": [",
+        indent, (unsigned long long) h.count(),
+        indent, h.min_us(),
+        indent, h.avg_us(),
+        indent, h.percentile_us(0.99),
+        indent, h.percentile_us(0.9999),
+        indent, h.max_us(),
+        indent, (unsigned long long) h.overflows(),
+        indent
+    );
+
+    const char * separator = "";
+    const std::vector<std::uint64_t> & b = h.buckets();
+    for (std::size_t i = 0; i < b.size(); ++i)
+    {
+        if (b[i] > 0)
+        {
+            std::fprintf
+            (
+                f, "%s[%u, %llu]", separator,
+                unsigned(i), (unsigned long long) b[i]
+            );
+            separator = ", ";
+        }
+    }
+    std::fprintf(f, "]\n");
+}
+
+/**
+ *  Writes the results as JSON.  The histogram is a list of [ bucket-us,
+ *  count ] pairs for the non-empty buckets; bucket "n" holds the
+ *  latencies from n to n + 1 microseconds.
+ */
+
+static bool
+write_json
+(
+    const settings & s,
+    const std::vector<histogram> & per_thread,
+    const histogram & all
+)
+{
+    bool to_stdout = s.json == "-";
+    std::FILE * f = to_stdout ? stdout : std::fopen(s.json.c_str(), "w") ;
+    if (f == nullptr)
+    {
+        std::fprintf(stderr, "Cannot write %s\n", s.json.c_str());
+        return false;
+    }
+    std::fprintf
+    (
+        f,
+        "{\n"
+        "  \"mode\": \"%s\",\n"
+        "  \"threads\": %d,\n"
+        "  \"priority\": %d,\n"
+        "  \"interval_us\": %d,\n"
+        "  \"loops\": %d,\n"
+        "  \"histogram_us\": %d,\n"
+        "  \"per_thread\": [\n",
+        mode_name(s.method), s.threads, s.priority, s.interval_us,
+        s.loops, s.histogram_us
+    );
+    for (std::size_t t = 0; t < per_thread.size(); ++t)
+    {
+        std::fprintf(f, "    {\n      \"thread\": %u,\n", unsigned(t));
+        write_stats(f, per_thread[t], "      ");
+        std::fprintf(f, "    }%s\n", t + 1 < per_thread.size() ? "," : "");
+    }
+    std::fprintf(f, "  ],\n  \"all\": {\n");
+    write_stats(f, all, "    ");
+    std::fprintf(f, "  }\n}\n");
+    if (! to_stdout)
+        (void) std::fclose(f);
+
+    return true;
+}
+
+static void
+usage ()
+{
+    std::fprintf
+    (
+        stderr,
+        "latency_benchmark [ -m sleep | periodic | precise ] [ -t threads ]\n"
+        "    [ -p priority ] [ -i interval-us ] [ -l loops ]\n"
+        "    [ -b histogram-us ] [ -j file.json | - ]\n"
+    );
+}
+
+/*
+ * main() routine
+ */
+
+int
+main (int argc, char * argv [])
+{
+    settings s { mode::periodic, 1, 0, 1000, 5000, 1000, "" };
+    for (int i = 1; i < argc; ++i)
+    {
+        const char * opt = argv[i];
+        const char * arg = i + 1 < argc ? argv[i + 1] : nullptr ;
+        if (arg == nullptr || opt[0] != '-' || opt[1] == 0 || opt[2] != 0)
+        {
+            usage();
+            return EXIT_FAILURE;
+        }
+        ++i;
+        switch (opt[1])
+        {
+        case 'm':
+
+            if (std::strcmp(arg, "sleep") == 0)
+                s.method = mode::sleep;
+            else if (std::strcmp(arg, "periodic") == 0)
+                s.method = mode::periodic;
+            else if (std::strcmp(arg, "precise") == 0)
+                s.method = mode::precise;
+            else
+            {
+                usage();
+                return EXIT_FAILURE;
+            }
+            break;
+
+        case 't':   s.threads = std::atoi(arg);         break;
+        case 'p':   s.priority = std::atoi(arg);        break;
+        case 'i':   s.interval_us = std::atoi(arg);     break;
+        case 'l':   s.loops = std::atoi(arg);           break;
+        case 'b':   s.histogram_us = std::atoi(arg);    break;
+        case 'j':   s.json = arg;                       break;
+        default:
+
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (s.threads <= 0 || s.interval_us <= 0 || s.loops <= 0 ||
+        s.histogram_us <= 0 || s.priority < 0)
+    {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if (s.method == mode::precise)
+        (void) xpc::calibrate_precise_sleep();
+
+    std::vector<histogram> per_thread(std::size_t(s.threads),
+        histogram(s.histogram_us));
+
+    std::vector<std::thread> workers;
+    xpc::latch start(1);
+    for (int t = 0; t < s.threads; ++t)
+    {
+        workers.emplace_back
+        (
+            measure, std::cref(s), std::ref(start), std::ref(per_thread[t])
+        );
+    }
+
+    bool prioritized = true;
+    if (s.priority > 0)
+    {
+        for (auto & w : workers)
+        {
+            if (! xpc::set_thread_priority(w, s.priority))
+                prioritized = false;
+        }
+    }
+    start.count_down();
+    for (auto & w : workers)
+        w.join();
+
+    histogram all(s.histogram_us);
+    for (const auto & h : per_thread)
+        all.merge(h);
+
+    if (! prioritized)
+        std::fprintf(stderr, "Could not set priority %d\n", s.priority);
+
+    if (s.json != "-")                          /* keep stdout pure JSON    */
+    {
+        std::printf
+        (
+            "Wakeup latency, %s, %d thread(s), %d x %d us, priority %d\n\n"
+            "%8s %10s %10s %10s %10s %10s %10s %9s\n",
+            mode_name(s.method), s.threads, s.loops, s.interval_us,
+            s.priority,
+            "thread", "samples", "min us", "avg us", "p99 us",
+            "p99.99 us", "max us", "overflow"
+        );
+        for (std::size_t t = 0; t < per_thread.size(); ++t)
+        {
+            std::string name = std::to_string(t);
+            print_row(name.c_str(), per_thread[t]);
+        }
+        if (per_thread.size() > 1)
+            print_row("all", all);
+    }
+    if (! s.json.empty())
+    {
+        if (! write_json(s, per_thread, all))
+            return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/*
+ * latency_benchmark.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
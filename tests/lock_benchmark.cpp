@@ -0,0 +1,450 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          lock_benchmark.cpp
+ *
+ *      A benchmark comparing the xpc66 locks under contention.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Usage:
+ *
+ *      lock_benchmark [ milliseconds-per-case ]
+ *
+ *  Reader scalability: 1 to 16 threads read a small shared structure for a
+ *  fixed time, once under a recmutex (via automutex) and once under a
+ *  rwmutex (via autoreadlock).  A single writer thread updates the
+ *  structure every millisecond during each case, so the table also shows
+ *  that the writer-preferring rwmutex does not starve the writer.
+ *
+ *  Exclusive contention: 2 to 32 threads hammer one lock with a tiny
+ *  critical section, once with recmutex and once with queuemutex (both via
+ *  autolock<>).  Each thread times every acquisition, and the table shows
+ *  the throughput plus the median, 99th percentile, and worst acquire
+ *  latency.  The unfairness of the pthread mutex shows up in the tail.
+ *
+ *  Owner-dominated locking: one "real-time" thread locks and unlocks as
+ *  fast as it can, alone and then with a "GUI" thread taking the lock once
+ *  per millisecond, under a recmutex and under the owner side of a
+ *  biasedmutex.  The table shows the owner's cost per lock/unlock pair.
+ */
+
+#include <algorithm>                    /* std::sort()                      */
+#include <atomic>                       /* std::atomic<>                    */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, std::atoi()        */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/automutex.hpp"            /* xpc::automutex, xpc::recmutex    */
+#include "xpc/biasedmutex.hpp"          /* xpc::biasedmutex                 */
+#include "xpc/queuemutex.hpp"           /* xpc::queuemutex                  */
+#include "xpc/rwmutex.hpp"              /* xpc::rwmutex and its guards      */
+#include "xpc/timing.hpp"               /* xpc::millisleep(), microtime()   */
+
+/*
+ *  The "read-mostly" state shared by all of the threads.
+ */
+
+struct shared_state
+{
+    long beats;
+    long ticks;
+    double tempo;
+};
+
+static shared_state s_state { 0, 0, 120.0 };
+
+/*
+ *  Results of one benchmark case.
+ */
+
+struct case_result
+{
+    double mops;                        /* million reads per second         */
+    long writes;                        /* writes achieved during the case  */
+};
+
+/**
+ *  Runs one case.  Each reader thread calls the reader function until told
+ *  to stop, counting its reads.  The writer thread calls the writer
+ *  function once per millisecond.
+ */
+
+template <typename READER, typename WRITER>
+static case_result
+run_case (int readers, int ms, READER reader, WRITER writer)
+{
+    std::atomic<bool> go { false };
+    std::atomic<bool> stop { false };
+    std::vector<long> counts(readers, 0);
+    std::vector<std::thread> threads;
+    long writes = 0;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back
+        (
+            [&, r] ()
+            {
+                long count = 0;
+                while (! go)
+                    xpc::thread_yield();
+
+                while (! stop.load(std::memory_order_relaxed))
+                {
+                    reader();
+                    ++count;
+                }
+                counts[r] = count;
+            }
+        );
+    }
+    std::thread w
+    (
+        [&] ()
+        {
+            while (! go)
+                xpc::thread_yield();
+
+            while (! stop)
+            {
+                writer();
+                ++writes;
+                (void) xpc::millisleep(1);
+            }
+        }
+    );
+    long start = xpc::microtime();
+    go = true;
+    (void) xpc::millisleep(ms);
+    stop = true;
+    long elapsed = xpc::microtime() - start;
+    for (auto & t : threads)
+        t.join();
+
+    w.join();
+
+    long total = 0;
+    for (auto c : counts)
+        total += c;
+
+    return case_result{ double(total) / double(elapsed), writes };
+}
+
+/*
+ *  Results of one contention case.  Latencies are in nanoseconds.
+ */
+
+struct contention_result
+{
+    double mops;                        /* million acquisitions per second  */
+    long p50;
+    long p99;
+    long max;
+};
+
+/**
+ *  The maximum number of latency samples kept per thread.
+ */
+
+static const std::size_t c_max_samples = 1 << 16;
+
+/**
+ *  Runs one contention case.  Every thread locks the same MUTEX, bumps a
+ *  shared counter, and unlocks, timing each acquisition.
+ */
+
+template <typename MUTEX>
+static contention_result
+run_contention (MUTEX & m, int threadcount, int ms)
+{
+    using clock = std::chrono::steady_clock;
+    std::atomic<bool> go { false };
+    std::atomic<bool> stop { false };
+    std::vector<long> counts(threadcount, 0);
+    std::vector<std::vector<long>> samples(threadcount);
+    std::vector<std::thread> threads;
+    long shared_counter = 0;
+    for (int t = 0; t < threadcount; ++t)
+    {
+        samples[t].reserve(c_max_samples);
+        threads.emplace_back
+        (
+            [&, t] ()
+            {
+                long count = 0;
+                auto & mine = samples[t];
+                while (! go)
+                    xpc::thread_yield();
+
+                while (! stop.load(std::memory_order_relaxed))
+                {
+                    auto t0 = clock::now();
+                    xpc::autolock<MUTEX> locker{m};
+                    auto t1 = clock::now();
+                    ++shared_counter;
+                    ++count;
+                    if (mine.size() < c_max_samples)
+                    {
+                        mine.push_back
+                        (
+                            long(std::chrono::duration_cast
+                            <
+                                std::chrono::nanoseconds
+                            >(t1 - t0).count())
+                        );
+                    }
+                }
+                counts[t] = count;
+            }
+        );
+    }
+    long start = xpc::microtime();
+    go = true;
+    (void) xpc::millisleep(ms);
+    stop = true;
+    long elapsed = xpc::microtime() - start;
+    for (auto & th : threads)
+        th.join();
+
+    long total = 0;
+    std::vector<long> all;
+    for (int t = 0; t < threadcount; ++t)
+    {
+        total += counts[t];
+        all.insert(all.end(), samples[t].begin(), samples[t].end());
+    }
+    contention_result result { double(total) / double(elapsed), 0, 0, 0 };
+    if (! all.empty())
+    {
+        std::sort(all.begin(), all.end());
+        result.p50 = all[all.size() / 2];
+        result.p99 = all[(all.size() * 99) / 100];
+        result.max = all.back();
+    }
+    return result;
+}
+
+/*
+ *  Results of one owner-dominated case.
+ */
+
+struct owner_result
+{
+    double ns_per_lock;                 /* the owner's cost per lock/unlock */
+    long guest_locks;                   /* guest acquisitions in the case   */
+};
+
+/**
+ *  Runs one owner-dominated case.  The owner calls OWNER, which locks,
+ *  bumps the counter, and unlocks, until told to stop.  If "with_guest" is
+ *  true, another thread calls GUEST once per millisecond.
+ */
+
+template <typename OWNER, typename GUEST>
+static owner_result
+run_owner_case (int ms, bool with_guest, OWNER owner, GUEST guest)
+{
+    std::atomic<bool> stop { false };
+    long locks = 0;
+    long guest_locks = 0;
+    long elapsed = 0;
+    std::thread o
+    (
+        [&] ()
+        {
+            long start = xpc::microtime();
+            while (! stop.load(std::memory_order_relaxed))
+            {
+                for (int i = 0; i < 1000; ++i)
+                    owner();
+
+                locks += 1000;
+            }
+            elapsed = xpc::microtime() - start;
+        }
+    );
+    std::thread g;
+    if (with_guest)
+    {
+        g = std::thread
+        (
+            [&] ()
+            {
+                while (! stop)
+                {
+                    guest();
+                    ++guest_locks;
+                    (void) xpc::millisleep(1);
+                }
+            }
+        );
+    }
+    (void) xpc::millisleep(ms);
+    stop = true;
+    o.join();
+    if (g.joinable())
+        g.join();
+
+    double ns = locks > 0 ? 1000.0 * double(elapsed) / double(locks) : 0.0 ;
+    return owner_result{ ns, guest_locks };
+}
+
+/*
+ * main() routine
+ */
+
+int
+main (int argc, char * argv [])
+{
+    int ms = argc > 1 ? std::atoi(argv[1]) : 250 ;
+    if (ms <= 0)
+        ms = 250;
+
+    xpc::recmutex rm;
+    xpc::rwmutex rw;
+    volatile long sink = 0;
+    std::printf
+    (
+        "Reader scalability, %d ms per case, one writer at 1 kHz\n\n"
+        "%8s %14s %8s %14s %8s %8s\n",
+        ms, "readers", "recmutex Mr/s", "writes", "rwmutex Mr/s", "writes",
+        "speedup"
+    );
+    for (int readers = 1; readers <= 16; readers *= 2)
+    {
+        case_result rec = run_case
+        (
+            readers, ms,
+            [&] ()
+            {
+                xpc::automutex locker{rm};
+                sink = s_state.beats + s_state.ticks;
+            },
+            [&] ()
+            {
+                xpc::automutex locker{rm};
+                ++s_state.beats;
+                ++s_state.ticks;
+            }
+        );
+        case_result shr = run_case
+        (
+            readers, ms,
+            [&] ()
+            {
+                xpc::autoreadlock locker{rw};
+                sink = s_state.beats + s_state.ticks;
+            },
+            [&] ()
+            {
+                xpc::autowritelock locker{rw};
+                ++s_state.beats;
+                ++s_state.ticks;
+            }
+        );
+        std::printf
+        (
+            "%8d %14.2f %8ld %14.2f %8ld %7.2fx\n",
+            readers, rec.mops, rec.writes, shr.mops, shr.writes,
+            rec.mops > 0.0 ? shr.mops / rec.mops : 0.0
+        );
+    }
+    std::printf
+    (
+        "\nExclusive contention, %d ms per case, latency in ns\n\n"
+        "%8s %10s %8s %8s %10s   %10s %8s %8s %10s\n",
+        ms, "threads",
+        "rec Mop/s", "p50", "p99", "max",
+        "mcs Mop/s", "p50", "p99", "max"
+    );
+    for (int threadcount = 2; threadcount <= 32; threadcount *= 2)
+    {
+        xpc::queuemutex qm;
+        contention_result rec = run_contention(rm, threadcount, ms);
+        contention_result mcs = run_contention(qm, threadcount, ms);
+        std::printf
+        (
+            "%8d %10.2f %8ld %8ld %10ld   %10.2f %8ld %8ld %10ld\n",
+            threadcount,
+            rec.mops, rec.p50, rec.p99, rec.max,
+            mcs.mops, mcs.p50, mcs.p99, mcs.max
+        );
+    }
+
+    xpc::biasedmutex bm;
+    long counter = 0;
+    std::printf
+    (
+        "\nOwner-dominated locking, %d ms per case, owner ns per lock, "
+        "biasedmutex %s\n\n%12s %12s %12s %12s\n",
+        ms, bm.asymmetric() ? "using membarrier()" : "using fences",
+        "guest", "recmutex", "biased", "guest locks"
+    );
+    for (int with_guest = 0; with_guest < 2; ++with_guest)
+    {
+        owner_result rec = run_owner_case
+        (
+            ms, with_guest != 0,
+            [&] ()
+            {
+                xpc::automutex locker{rm};
+                ++counter;
+            },
+            [&] ()
+            {
+                xpc::automutex locker{rm};
+                sink = counter;
+            }
+        );
+        owner_result bia = run_owner_case
+        (
+            ms, with_guest != 0,
+            [&] ()
+            {
+                xpc::autoownerlock locker{bm};
+                ++counter;
+            },
+            [&] ()
+            {
+                xpc::autolock<xpc::biasedmutex> locker{bm};
+                sink = counter;
+            }
+        );
+        std::printf
+        (
+            "%12s %12.2f %12.2f %12ld\n",
+            with_guest != 0 ? "1 kHz" : "none",
+            rec.ns_per_lock, bia.ns_per_lock, bia.guest_locks
+        );
+    }
+    (void) sink;
+    return EXIT_SUCCESS;
+}
+
+/*
+ * lock_benchmark.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
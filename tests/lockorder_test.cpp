@@ -0,0 +1,132 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          lockorder_test.cpp
+ *
+ *      Tests of the debug-build lock-order checker with static recmutexes.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Two static named recmutexes are locked in both orders on one thread,
+ *  which must be reported as one inversion.  The mutexes are built before
+ *  the checker's state, so they are destroyed after it would be, if that
+ *  state were ordinary statics; the destructors then forget the mutexes in
+ *  a destroyed graph.  That is checked simply by exiting: run it under
+ *  AddressSanitizer or valgrind to see a use-after-free.
+ *
+ *  A copied or assigned recmutex keeps its name.
+ *
+ *  In a release build (no XPC66_LOCK_ORDER_CHECK) only the names are
+ *  checked.
+ */
+
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <cstring>                      /* std::strcmp()                    */
+
+#include "xpc/lockorder.hpp"            /* xpc::lock_order_violations()     */
+#include "xpc/recmutex.hpp"             /* xpc::recmutex                    */
+
+static xpc::recmutex s_alpha("alpha");
+static xpc::recmutex s_beta("beta");
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+static bool
+named (const xpc::recmutex & m, const char * n)
+{
+    return m.name() != nullptr && std::strcmp(m.name(), n) == 0;
+}
+
+static void
+test_names ()
+{
+    xpc::recmutex gamma("gamma");
+    xpc::recmutex copied(gamma);
+    xpc::recmutex assigned;
+    assigned = gamma;
+    check(named(copied, "gamma"), "a copied recmutex keeps its name");
+    check(named(assigned, "gamma"), "an assigned recmutex keeps its name");
+}
+
+#if defined XPC66_LOCK_ORDER_CHECK
+
+static void
+test_inversion ()
+{
+    xpc::lock_order_reset();
+    s_alpha.lock();
+    s_beta.lock();
+    s_beta.unlock();
+    s_alpha.unlock();
+    check(xpc::lock_order_violations() == 0, "one order is no inversion");
+
+    std::printf("An inversion report for 'alpha' and 'beta' follows:\n");
+    std::fflush(stdout);
+    s_beta.lock();
+    s_alpha.lock();
+    s_alpha.unlock();
+    s_beta.unlock();
+    check(xpc::lock_order_violations() == 1, "both orders are reported");
+
+    s_beta.lock();
+    s_alpha.lock();
+    s_alpha.unlock();
+    s_beta.unlock();
+    check(xpc::lock_order_violations() == 1, "a pair is reported once");
+}
+
+#endif
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    test_names();
+#if defined XPC66_LOCK_ORDER_CHECK
+    test_inversion();
+#endif
+    if (s_failures == 0)
+        std::printf("lockorder_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * lockorder_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,214 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          semaphore_test.cpp
+ *
+ *      Tests of xpc::semaphore and xpc::autoevent.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Semaphore: the count starts at the initial value, post(n) adds n, and
+ *  each try_wait() or wait() takes one; with nothing to take, try_wait()
+ *  fails and wait_for() times out.  Several consumers sharing the posts of
+ *  one producer take exactly as many as were posted, and post(n) wakes n
+ *  sleepers.
+ *
+ *  Autoevent: a signal is taken by exactly one wait, which clears the
+ *  event; signals do not count up; reset() clears it.  One signal wakes one
+ *  of two sleepers, and the next signal wakes the other.
+ */
+
+#include <atomic>                       /* std::atomic<int>                 */
+#include <cstdint>                      /* std::int64_t                     */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/semaphore.hpp"            /* xpc::semaphore, xpc::autoevent   */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), millisleep()    */
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+static void
+test_counts ()
+{
+    xpc::semaphore s(2);
+    check(s.count() == 2, "semaphore: starts at the initial count");
+    check(s.try_wait() && s.try_wait(), "semaphore: takes the initial count");
+    check(! s.try_wait(), "semaphore: nothing left to take");
+    s.post(3);
+    s.post(0);
+    s.post(-1);
+    check(s.count() == 3, "semaphore: post(n) adds n, and only n > 0");
+    s.wait();
+    check(s.wait_for(1000), "semaphore: wait_for() takes an available count");
+    check(s.count() == 1, "semaphore: each wait takes one");
+    check(s.try_wait(), "semaphore: the last one");
+
+    std::int64_t t0 = xpc::nanotime();
+    bool taken = s.wait_for(20000);
+    std::int64_t waited = xpc::nanotime() - t0;
+    check(! taken, "semaphore: wait_for() times out at zero");
+    check(waited >= 20000000, "semaphore: ... after the time given");
+    check(xpc::semaphore(-5).count() == 0, "semaphore: negative start is 0");
+}
+
+static void
+test_consumers ()
+{
+    const int consumers = 4;
+    const int each = 5000;
+    xpc::semaphore s;
+    std::atomic<int> taken { 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < consumers; ++i)
+    {
+        threads.emplace_back
+        (
+            [&s, &taken] ()
+            {
+                for (int k = 0; k < each; ++k)
+                {
+                    s.wait();
+                    ++taken;
+                }
+            }
+        );
+    }
+    for (int posted = 0; posted < consumers * each; )
+    {
+        int n = 1 + posted % 7;
+        if (n > consumers * each - posted)
+            n = consumers * each - posted;
+
+        s.post(n);
+        posted += n;
+    }
+    for (auto & t : threads)
+        t.join();
+
+    check(taken == consumers * each, "semaphore: every post is taken");
+    check(s.count() == 0, "semaphore: ... exactly once");
+
+    std::atomic<int> woken { 0 };
+    threads.clear();
+    for (int i = 0; i < 3; ++i)
+    {
+        threads.emplace_back
+        (
+            [&s, &woken] ()
+            {
+                if (s.wait_for(5000000))
+                    ++woken;
+            }
+        );
+    }
+    (void) xpc::millisleep(50);
+    std::int64_t t0 = xpc::nanotime();
+    s.post(3);
+    for (auto & t : threads)
+        t.join();
+
+    check(woken == 3, "semaphore: post(3) wakes 3 sleepers");
+    check
+    (
+        xpc::nanotime() - t0 < 1000000000,
+        "semaphore: ... at once, not at the time limit"
+    );
+}
+
+static void
+test_autoevent ()
+{
+    xpc::autoevent e;
+    check(! e.is_set() && ! e.try_wait(), "autoevent: starts clear");
+    e.signal();
+    e.signal();
+    check(e.is_set(), "autoevent: signal() sets it");
+    check(e.try_wait(), "autoevent: a wait takes it");
+    check(! e.is_set(), "autoevent: ... and clears it");
+    check(! e.try_wait(), "autoevent: two signals are not two events");
+
+    xpc::autoevent set(true);
+    check(set.is_set(), "autoevent: can start set");
+    set.reset();
+    check(! set.try_wait(), "autoevent: reset() clears it");
+    check(! set.wait_for(20000), "autoevent: wait_for() times out");
+
+    std::atomic<int> woken { 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i)
+    {
+        threads.emplace_back
+        (
+            [&e, &woken] ()
+            {
+                if (e.wait_for(5000000))
+                    ++woken;
+            }
+        );
+    }
+    (void) xpc::millisleep(50);
+    e.signal();
+    (void) xpc::millisleep(100);
+    check(woken == 1, "autoevent: one signal wakes one of two waiters");
+    check(! e.is_set(), "autoevent: ... which clears it");
+    e.signal();
+    for (auto & t : threads)
+        t.join();
+
+    check(woken == 2, "autoevent: the next signal wakes the other");
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    test_counts();
+    test_consumers();
+    test_autoevent();
+    if (s_failures == 0)
+        std::printf("semaphore_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * semaphore_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,251 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          stoptoken_test.cpp
+ *
+ *      Tests of the stop tokens and the waits that accept them.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Usage:
+ *
+ *      stoptoken_test [ iterations ]
+ *
+ *  Callbacks: a callback runs once on request_stop(); one that is
+ *  destroyed first does not run; request_stop_async() runs none until
+ *  run_callbacks().
+ *
+ *  Session: after session_setup(), a SIGINT wakes a millisleep() with
+ *  session_stop_token() (at once in Linux, else at session_close()), and
+ *  session_close() runs the token's callbacks, which wake a
+ *  condition::wait() with it.  A second session_setup(), as for a
+ *  restart, gives an unstopped token whose sleeps really sleep.
+ *
+ *  Stress: in each iteration three threads wait with condition::wait(token)
+ *  on one condition, with a fresh stop_source, and the main thread
+ *  requests the stop while they are entering the wait.  Running the
+ *  callbacks under the stop state's lock used to deadlock this after
+ *  60000 to 300000 iterations on a multi-core machine (the default is
+ *  100000).  A watchdog fails the test if it hangs.
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <chrono>                       /* std::chrono::seconds             */
+#include <csignal>                      /* std::raise(), SIGINT             */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdint>                      /* std::int64_t                     */
+#include <cstdlib>                      /* EXIT_SUCCESS, std::_Exit()       */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "platform_macros.h"            /* PLATFORM_UNIX                    */
+#include "xpc/condition.hpp"            /* xpc::condition                   */
+#include "xpc/daemonize.hpp"            /* xpc::session_setup(), etc.       */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_source, etc.           */
+#include "xpc/timing.hpp"               /* xpc::millisleep(), nanotime()    */
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+static void
+test_callbacks ()
+{
+    xpc::stop_source source;
+    int ran = 0;
+    int removed = 0;
+    {
+        xpc::stop_callback kept(source.get_token(), [&ran] { ++ran; });
+        {
+            xpc::stop_callback gone
+            (
+                source.get_token(), [&removed] { ++removed; }
+            );
+        }
+        check(source.request_stop(), "first request_stop() makes it");
+        check(! source.request_stop(), "second request_stop() does not");
+    }
+    check(ran == 1, "callback runs once");
+    check(removed == 0, "destroyed callback does not run");
+
+    xpc::stop_source async;
+    int later = 0;
+    xpc::stop_callback cb(async.get_token(), [&later] { ++later; });
+    check(async.request_stop_async(), "request_stop_async() makes it");
+    check(async.get_token().stop_requested(), "async stop is visible");
+    check(later == 0, "async stop runs no callbacks");
+    async.run_callbacks();
+    async.run_callbacks();
+    check(later == 1, "run_callbacks() runs them once");
+
+    int immediate = 0;
+    xpc::stop_callback now(async.get_token(), [&immediate] { ++immediate; });
+    check(immediate == 1, "callback after the stop runs at once");
+}
+
+static void
+test_stress (int iterations)
+{
+    const int waiters = 3;
+    xpc::condition cond;
+    for (int i = 0; i < iterations; ++i)
+    {
+        xpc::stop_source source;
+        xpc::stop_token token = source.get_token();
+        std::vector<std::thread> threads;
+        for (int w = 0; w < waiters; ++w)
+        {
+            threads.emplace_back
+            (
+                [&cond, token] ()
+                {
+                    cond.lock();
+                    while (cond.wait(token))
+                    {
+                        // spurious wakeup
+                    }
+                    cond.unlock();
+                }
+            );
+        }
+        if (i % 2 == 1)
+            std::this_thread::yield();
+
+        (void) source.request_stop();
+        for (auto & t : threads)
+            t.join();
+    }
+}
+
+#if defined PLATFORM_UNIX
+
+static void
+test_session ()
+{
+    xpc::session_setup();
+    xpc::stop_token token = xpc::session_stop_token();
+    std::atomic<std::int64_t> slept { 0 };
+    std::thread sleeper
+    (
+        [token, &slept] ()
+        {
+            std::int64_t t0 = xpc::nanotime();
+            (void) xpc::millisleep(10000, token);
+            slept = xpc::nanotime() - t0;
+        }
+    );
+
+    xpc::condition cond;
+    std::atomic<bool> woke { false };
+    std::thread waiter
+    (
+        [&cond, token, &woke] ()
+        {
+            cond.lock();
+            while (cond.wait(token))
+            {
+                // spurious wakeup
+            }
+            cond.unlock();
+            woke = true;
+        }
+    );
+    (void) xpc::millisleep(50);
+    (void) std::raise(SIGINT);
+#if defined PLATFORM_LINUX
+    check(token.stop_requested(), "SIGINT stops the session token");
+#endif
+    check(xpc::session_close(), "SIGINT requests the close");
+    sleeper.join();
+    check(slept < 1000000000, "SIGINT wakes the session token sleep");
+    check(token.stop_requested(), "session_close() finishes the stop");
+    waiter.join();
+    check(woke, "session_close() wakes the session token wait");
+
+    xpc::session_setup();
+    xpc::stop_token fresh = xpc::session_stop_token();
+    check(! fresh.stop_requested(), "a restart gets an unstopped token");
+    check(token.stop_requested(), "the old token stays stopped");
+
+    std::int64_t t0 = xpc::nanotime();
+    bool full = xpc::millisleep(30, fresh);
+    std::int64_t ns = xpc::nanotime() - t0;
+    check(full && ns >= 25000000, "the new token's sleep really sleeps");
+}
+
+#endif
+
+/*
+ * main() routine
+ */
+
+int
+main (int argc, char * argv [])
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 100000 ;
+    if (iterations <= 0)
+        iterations = 100000;
+
+    std::atomic<bool> done { false };
+    std::thread watchdog
+    (
+        [&done] ()
+        {
+            for (int s = 0; s < 120 && ! done; ++s)
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+
+            if (! done)
+            {
+                std::printf("FAILED: hung (deadlock?)\n");
+                std::_Exit(EXIT_FAILURE);
+            }
+        }
+    );
+    test_callbacks();
+    test_stress(iterations);
+    std::printf("%d stress iterations done\n", iterations);
+#if defined PLATFORM_UNIX
+    test_session();
+#endif
+
+    done = true;
+    watchdog.join();
+    if (s_failures == 0)
+        std::printf("stoptoken_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * stoptoken_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,201 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          synchronizer_test.cpp
+ *
+ *      Tests of the timed waits and signal_all() of xpc::synchronizer.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Timeout: wait_for() and wait_until() return false, no sooner than the
+ *  time given, when the predicate stays false; with the predicate already
+ *  true they return true at once.
+ *
+ *  Wake: a signal() wakes a timed waiter long before its time limit, and
+ *  signal_all() wakes every waiter.
+ *
+ *  Each test is run with the default synchronizer and with one that has an
+ *  atomic predicate (and so skips signals when nobody waits).
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdint>                      /* std::int64_t                     */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/condition.hpp"            /* xpc::synchronizer                */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), millisleep()    */
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+/**
+ *  A synchronizer whose predicate is one atomic flag.
+ */
+
+class flag_synch : public xpc::synchronizer
+{
+
+public:
+
+    std::atomic<bool> flag;
+
+    explicit flag_synch (bool atomic_predicate) :
+        xpc::synchronizer   (atomic_predicate),
+        flag                (false)
+    {
+        // no code
+    }
+
+    virtual bool predicate () const override
+    {
+        return flag.load();
+    }
+
+};
+
+static void
+test_timeout (bool atomic)
+{
+    flag_synch s(atomic);
+    std::int64_t t0 = xpc::nanotime();
+    bool ready = s.wait_for(20000);
+    std::int64_t waited = xpc::nanotime() - t0;
+    check(! ready, "timeout: wait_for() returns false");
+    check(waited >= 20000000, "timeout: wait_for() waits the time given");
+    check(waited < 1000000000, "timeout: ... and not much more");
+
+    auto deadline = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(20);
+
+    ready = s.wait_until(deadline);
+    check(! ready, "timeout: wait_until() returns false");
+    check
+    (
+        std::chrono::steady_clock::now() >= deadline,
+        "timeout: wait_until() does not return before the deadline"
+    );
+    check(s.waiters() == 0, "timeout: no waiters left");
+
+    s.flag = true;
+    t0 = xpc::nanotime();
+    ready = s.wait_for(5000000);
+    waited = xpc::nanotime() - t0;
+    check(ready && waited < 10000000, "timeout: true predicate, no wait");
+}
+
+/**
+ *  Waits until the given number of threads are inside a wait.
+ */
+
+static void
+await_waiters (const flag_synch & s, int count)
+{
+    std::int64_t limit = xpc::nanotime() + 2000000000;
+    while (s.waiters() < count && xpc::nanotime() < limit)
+        (void) xpc::millisleep(1);
+}
+
+static void
+test_wake (bool atomic)
+{
+    flag_synch s(atomic);
+    bool ready = false;
+    std::thread one([&s, &ready] { ready = s.wait_for(5000000); });
+    await_waiters(s, 1);
+    std::int64_t t0 = xpc::nanotime();
+    s.flag = true;
+    s.signal();
+    one.join();
+    check(ready, "wake: signal() wakes a timed waiter");
+    check
+    (
+        xpc::nanotime() - t0 < 1000000000,
+        "wake: ... well before its time limit"
+    );
+
+    const int count = 3;
+    flag_synch all(atomic);
+    std::atomic<int> woken { 0 };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i)
+    {
+        threads.emplace_back
+        (
+            [&all, &woken] ()
+            {
+                if (all.wait_for(5000000))
+                    ++woken;
+            }
+        );
+    }
+    await_waiters(all, count);
+    t0 = xpc::nanotime();
+    all.flag = true;
+    all.signal_all();
+    for (auto & t : threads)
+        t.join();
+
+    check(woken == count, "wake: signal_all() wakes every waiter");
+    check
+    (
+        xpc::nanotime() - t0 < 1000000000,
+        "wake: ... well before their time limit"
+    );
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    for (int atomic = 0; atomic < 2; ++atomic)
+    {
+        test_timeout(atomic != 0);
+        test_wake(atomic != 0);
+    }
+    if (s_failures == 0)
+        std::printf("synchronizer_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * synchronizer_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
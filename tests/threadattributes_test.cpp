@@ -0,0 +1,262 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          threadattributes_test.cpp
+ *
+ *      Tests of thread_attributes::launch() and apply().
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Launch: the body checks, before doing anything else, that its name and
+ *  affinity are already the ones asked for.  (Linux only.)
+ *
+ *  Failure: fifo(0) is outside the SCHED_FIFO range, so launch() reports
+ *  step::policy, the body does not run, and the thread is left empty.
+ *
+ *  Deadline: deadline() with affinity() fails with EINVAL before the name
+ *  is applied; bad parameters fail with EINVAL; a period of 0 is accepted
+ *  (the kernel may still refuse it for lack of privilege).  (Linux only.)
+ *
+ *  Only the failure paths and the settings any user may make are tested,
+ *  so the test passes without real-time privileges.
+ */
+
+#include <atomic>                       /* std::atomic<>                    */
+#include <cerrno>                       /* EINVAL                           */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <cstring>                      /* std::strcmp()                    */
+#include <thread>                       /* std::thread                      */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/threadattributes.hpp"     /* xpc::thread_attributes           */
+
+#if defined PLATFORM_LINUX
+#include <pthread.h>                    /* pthread_getname_np(), etc.       */
+#include <sched.h>                      /* cpu_set_t, sched_getaffinity()   */
+#endif
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+#if defined PLATFORM_LINUX
+
+/**
+ *  Gets the first CPU the process may run on, or -1.
+ */
+
+static int
+first_allowed_cpu ()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof set, &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                return cpu;
+        }
+    }
+    return -1;
+}
+
+static bool
+name_is (const char * expected)
+{
+    char n[32];
+    return pthread_getname_np(pthread_self(), n, sizeof n) == 0 &&
+        std::strcmp(n, expected) == 0;
+}
+
+static void
+test_launch ()
+{
+    int cpu = first_allowed_cpu();
+    check(cpu >= 0, "launch: found an allowed CPU");
+    if (cpu < 0)
+        return;
+
+    std::atomic<bool> ran { false };
+    std::atomic<bool> named { false };
+    std::atomic<bool> pinned { false };
+    std::thread t;
+    xpc::thread_status s = xpc::thread_attributes()
+        .name("xpc-attr-test-too-long")
+        .affinity({ cpu })
+        .prefault_stack(64 * 1024)
+        .launch
+        (
+            t,
+            [&ran, &named, &pinned, cpu] ()
+            {
+                named = name_is("xpc-attr-test-t");
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (pthread_getaffinity_np(pthread_self(), sizeof set, &set)
+                        == 0)
+                {
+                    pinned = CPU_COUNT(&set) == 1 && CPU_ISSET(cpu, &set);
+                }
+                ran = true;
+            }
+        );
+
+    check(s.ok(), "launch: succeeds");
+    check(t.joinable(), "launch: thread is running");
+    if (t.joinable())
+        t.join();
+
+    check(ran, "launch: body runs");
+    check(named, "launch: name (cut to 15) applied before the body");
+    check(pinned, "launch: affinity applied before the body");
+}
+
+static void
+test_deadline ()
+{
+    std::atomic<bool> ran { false };
+    std::thread t;
+    xpc::thread_status s = xpc::thread_attributes()
+        .deadline(1000000, 10000000, 10000000)
+        .affinity({ 0 })
+        .launch(t, [&ran] { ran = true; });
+
+    check
+    (
+        s.failed == xpc::thread_status::step::policy,
+        "deadline + affinity: fails in the policy step"
+    );
+    check(s.error == EINVAL, "deadline + affinity: EINVAL");
+    check(! ran, "deadline + affinity: body not run");
+    check(! t.joinable(), "deadline + affinity: thread left empty");
+
+    bool unnamed = false;
+    std::thread probe
+    (
+        [&unnamed] ()
+        {
+            (void) xpc::thread_attributes()
+                .name("dl-affinity")
+                .deadline(1000000, 10000000, 0)
+                .affinity({ 0 })
+                .best_effort()
+                .apply();
+
+            unnamed = ! name_is("dl-affinity");
+        }
+    );
+    probe.join();
+    check(unnamed, "deadline + affinity: nothing applied, even best effort");
+
+    s = xpc::thread_attributes().deadline(2000000, 1000000, 0).apply();
+    check(s.error == EINVAL, "deadline: runtime > deadline is EINVAL");
+    s = xpc::thread_attributes().deadline(1000000, 2000000, 1500000).apply();
+    check(s.error == EINVAL, "deadline: deadline > period is EINVAL");
+
+    ran = false;
+    s = xpc::thread_attributes()
+        .deadline(1000000, 10000000, 0)
+        .launch(t, [&ran] { ran = true; });
+
+    check(s.ok() || s.error != EINVAL, "deadline: period 0 is accepted");
+    if (t.joinable())
+        t.join();
+
+    check(ran == s.ok(), "deadline: body runs if the policy was set");
+    std::printf
+    (
+        "deadline, period 0: %s\n", s.ok() ? "set" : s.message.c_str()
+    );
+}
+
+#endif      // PLATFORM_LINUX
+
+static void
+test_failure ()
+{
+    std::atomic<bool> ran { false };
+    std::thread t;
+    xpc::thread_status s = xpc::thread_attributes()
+        .fifo(0)
+        .launch(t, [&ran] { ran = true; });
+
+    check(! s.ok(), "fifo(0): fails");
+    check
+    (
+        s.failed == xpc::thread_status::step::policy,
+        "fifo(0): fails in the policy step"
+    );
+    check(! s.message.empty(), "fifo(0): has a message");
+    check(! ran, "fifo(0): body not run");
+    check(! t.joinable(), "fifo(0): thread left empty");
+
+    s = xpc::thread_attributes()
+        .fifo(0)
+        .best_effort()
+        .launch(t, [&ran] { ran = true; });
+
+    check
+    (
+        s.failed == xpc::thread_status::step::policy,
+        "fifo(0), best effort: still reports the failure"
+    );
+    check(t.joinable(), "fifo(0), best effort: thread running");
+    if (t.joinable())
+        t.join();
+
+    check(ran, "fifo(0), best effort: body runs");
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+#if defined PLATFORM_LINUX
+    test_launch();
+    test_deadline();
+#endif
+    test_failure();
+    if (s_failures == 0)
+        std::printf("threadattributes_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * threadattributes_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
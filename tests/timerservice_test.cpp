@@ -0,0 +1,300 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timerservice_test.cpp
+ *
+ *      Tests of the timer_service, driven the way an event loop drives it.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Each test polls fd() for readability and calls dispatch() when it is
+ *  readable, as an epoll loop would.  Without a timerfd (fd() is -1) it
+ *  sleeps until next_deadline_ns() instead.
+ *
+ *  One-shot: the descriptor is not readable before the deadline, the
+ *  timer runs once, not early, and is then gone.
+ *
+ *  Cancel: a cancelled timer does not run, although the descriptor was
+ *  armed for it.
+ *
+ *  Periodic: the main loop stalls once for several periods; afterwards
+ *  the runs plus missed() account for every deadline that has passed.
+ *
+ *  Callbacks: a callback adds a timer, another cancels a pending one, and a
+ *  periodic timer cancels itself.
+ */
+
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdint>                      /* std::int64_t                     */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+
+#include "platform_macros.h"            /* PLATFORM_UNIX                    */
+#include "xpc/timerservice.hpp"         /* xpc::timer_service               */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), etc.            */
+
+#if defined PLATFORM_UNIX
+#include <poll.h>                       /* poll(), POLLIN                   */
+#endif
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+/**
+ *  Waits up to timeout_ms for the service to become due, as an event loop
+ *  would, and dispatches it.  Returns the number of callbacks run.
+ */
+
+static int
+pump (xpc::timer_service & timers, int timeout_ms)
+{
+#if defined PLATFORM_UNIX
+    if (timers.fd() >= 0)
+    {
+        struct pollfd p;
+        p.fd = timers.fd();
+        p.events = POLLIN;
+        p.revents = 0;
+        if (poll(&p, 1, timeout_ms) <= 0)
+            return 0;
+
+        return timers.dispatch();
+    }
+#endif
+    std::int64_t limit = xpc::nanotime() + timeout_ms * 1000000LL;
+    std::int64_t next = timers.next_deadline_ns();
+    xpc::sleep_until_ns(next != 0 && next < limit ? next : limit);
+    return timers.dispatch();
+}
+
+/**
+ *  True if the descriptor is readable right now.  Without a timerfd it
+ *  checks the earliest deadline instead.
+ */
+
+static bool
+readable (xpc::timer_service & timers)
+{
+#if defined PLATFORM_UNIX
+    if (timers.fd() >= 0)
+    {
+        struct pollfd p;
+        p.fd = timers.fd();
+        p.events = POLLIN;
+        p.revents = 0;
+        return poll(&p, 1, 0) > 0;
+    }
+#endif
+    std::int64_t next = timers.next_deadline_ns();
+    return next != 0 && next <= xpc::nanotime();
+}
+
+static void
+test_oneshot ()
+{
+    xpc::timer_service timers;
+    int runs = 0;
+    std::int64_t ran_at = 0;
+    std::int64_t deadline = xpc::nanotime() + 20000000;
+    xpc::timer_service::timer_id id = timers.add_oneshot_at
+    (
+        deadline, [&runs, &ran_at] { ++runs; ran_at = xpc::nanotime(); }
+    );
+    check(id != 0, "one-shot: add_oneshot_at() gives an id");
+    check(timers.count() == 1, "one-shot: one timer pending");
+    check(! readable(timers), "one-shot: descriptor not readable early");
+
+    std::int64_t limit = xpc::nanotime() + 1000000000;
+    while (runs == 0 && xpc::nanotime() < limit)
+        (void) pump(timers, 100);
+
+    check(runs == 1, "one-shot: runs once");
+    check(ran_at >= deadline, "one-shot: does not run early");
+    check(timers.count() == 0, "one-shot: gone after running");
+    check(! timers.cancel(id), "one-shot: cannot be cancelled after running");
+    check(timers.next_deadline_ns() == 0, "one-shot: nothing left queued");
+    (void) pump(timers, 50);
+    check(runs == 1, "one-shot: does not run again");
+}
+
+static void
+test_cancel ()
+{
+    xpc::timer_service timers;
+    int cancelled = 0;
+    int sentinel = 0;
+    xpc::timer_service::timer_id id = timers.add_oneshot
+    (
+        10000, [&cancelled] { ++cancelled; }
+    );
+    (void) timers.add_oneshot(40000, [&sentinel] { ++sentinel; });
+    check(timers.cancel(id), "cancel: pending timer is cancelled");
+    check(! timers.cancel(id), "cancel: second cancel() fails");
+    check(timers.count() == 1, "cancel: one timer left");
+
+    std::int64_t limit = xpc::nanotime() + 1000000000;
+    while (sentinel == 0 && xpc::nanotime() < limit)
+        (void) pump(timers, 100);
+
+    check(sentinel == 1, "cancel: the other timer runs");
+    check(cancelled == 0, "cancel: cancelled timer does not run");
+}
+
+static void
+test_periodic ()
+{
+    const int period_us = 5000;
+    const std::int64_t period_ns = period_us * 1000LL;
+    xpc::timer_service timers;
+    std::int64_t runs = 0;
+    std::int64_t first = xpc::nanotime() + period_ns;
+    xpc::timer_service::timer_id id = timers.add_periodic
+    (
+        first, period_us, [&runs] { ++runs; }
+    );
+    check(id != 0, "periodic: add_periodic() gives an id");
+    check
+    (
+        timers.add_periodic(first, 0, [] { }) == 0,
+        "periodic: a zero period is refused"
+    );
+
+    bool stalled = false;
+    std::int64_t end = first + 40 * period_ns;
+    while (xpc::nanotime() < end)
+    {
+        (void) pump(timers, 100);
+        if (! stalled && runs >= 5)
+        {
+            (void) xpc::millisleep(int(6 * period_us / 1000));
+            stalled = true;
+        }
+    }
+
+    /*
+     * Each deadline up to the last dispatch was either run or missed, so
+     * the next deadline is that many periods after the first.
+     */
+
+    std::int64_t next = timers.next_deadline_ns();
+    std::int64_t missed = timers.missed();
+    check(missed > 0, "periodic: the stall misses deadlines");
+    check
+    (
+        next == first + (runs + missed) * period_ns,
+        "periodic: runs + missed() match the deadlines passed"
+    );
+    check
+    (
+        next - period_ns <= xpc::nanotime(),
+        "periodic: the last deadline counted has passed"
+    );
+    check(timers.cancel(id), "periodic: cancel() stops it");
+    check(timers.count() == 0, "periodic: nothing left");
+
+    std::int64_t before = runs;
+    (void) pump(timers, 2 * period_us / 1000);
+    check(runs == before, "periodic: does not run after cancel()");
+    std::printf
+    (
+        "periodic: %lld runs, %lld missed\n", (long long) runs,
+        (long long) missed
+    );
+}
+
+static void
+test_callbacks ()
+{
+    xpc::timer_service timers;
+    int chained = 0;
+    int victim = 0;
+    int self = 0;
+    xpc::timer_service::timer_id victim_id = timers.add_oneshot
+    (
+        60000, [&victim] { ++victim; }
+    );
+    (void) timers.add_oneshot
+    (
+        5000,
+        [&timers, &chained, victim_id] ()
+        {
+            (void) timers.cancel(victim_id);
+            (void) timers.add_oneshot(5000, [&chained] { ++chained; });
+        }
+    );
+
+    xpc::timer_service::timer_id self_id = 0;
+    self_id = timers.add_periodic
+    (
+        xpc::nanotime() + 2000000, 2000,
+        [&timers, &self, &self_id] ()
+        {
+            if (++self == 3)
+                (void) timers.cancel(self_id);
+        }
+    );
+
+    std::int64_t limit = xpc::nanotime() + 100000000;
+    while (xpc::nanotime() < limit)
+        (void) pump(timers, 10);
+
+    check(chained == 1, "callbacks: timer added by a callback runs");
+    check(victim == 0, "callbacks: timer cancelled by a callback does not");
+    check(self == 3, "callbacks: periodic timer cancels itself");
+    check(timers.count() == 0, "callbacks: nothing left");
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    xpc::timer_service probe;
+    if (! probe.valid())
+        std::printf("no timerfd; sleeping on next_deadline_ns() instead\n");
+
+    test_oneshot();
+    test_cancel();
+    test_periodic();
+    test_callbacks();
+    if (s_failures == 0)
+        std::printf("timerservice_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * timerservice_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
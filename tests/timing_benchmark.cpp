@@ -0,0 +1,473 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timing_benchmark.cpp
+ *
+ *      A benchmark of the accuracy of the xpc66 sleeps and timers.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Usage:
+ *
+ *      timing_benchmark [ ticks ]
+ *
+ *  Drift: an engine loop with a 1 ms period does 200 us of "work" per
+ *  cycle.  It is paced once by microsleep() of the period less the
+ *  measured work time, and once by a periodic_timer.  The table shows how
+ *  far behind the ideal schedule each loop ends up, and the equivalent
+ *  tempo error.  Any lag of the periodic_timer comes from ticks it had to
+ *  skip (a preempted cycle), which it reports; the other loop's lag is
+ *  silent.
+ *
+ *  Accuracy: for several sleep lengths, how late microsleep() and
+ *  precise_microsleep() wake up (mean, 99th percentile, and worst, in
+ *  microseconds), and the CPU time each uses as a percentage of the time
+ *  slept.  The precise wait trades the CPU of its spin for accuracy.
+ *
+ *  Timer slack: microsleep() lateness with the thread's default timer
+ *  slack, then after set_timer_services(true), which sets it to 1 ns in
+ *  Linux.  The default slack is then restored.  Measured on a one-CPU
+ *  virtual machine, the mean lateness of 50 us and 100 us sleeps fell
+ *  from about 60 us (the 50 us default slack plus wakeup latency) to
+ *  7-15 us, and the p99 from 65-265 us to 13-86 us.  Longer sleeps there
+ *  are dominated by preemption, and the gain is smaller.
+ *
+ *  Clock cost: nanoseconds per call of nanotime(), microtime(),
+ *  millitime(), std::chrono::steady_clock::now(), fastclock_ns() (if the
+ *  TSC is usable), coarse_nanotime(), cached_clock::nanotime(),
+ *  current_date_time(), and (in Linux) the old floating-point microtime().
+ *
+ *  Timers: the cost of schedule() and cancel() on a timing_wheel holding
+ *  N timers due within one second, and the cost per 1 ms tick of
+ *  advance(), against scanning a vector of N deadlines each tick.
+ */
+
+#include <algorithm>                    /* std::sort()                      */
+#include <chrono>                       /* std::chrono::steady_clock        */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, std::atoi()        */
+#include <cstdint>                      /* std::int64_t                     */
+#include <ctime>                        /* std::clock(), clock_gettime()    */
+#include <vector>                       /* std::vector<>                    */
+
+#include "platform_macros.h"            /* PLATFORM_LINUX                   */
+#include "xpc/coarseclock.hpp"          /* xpc::coarse_nanotime(), etc.     */
+#include "xpc/fastclock.hpp"            /* xpc::fastclock_ns()              */
+#include "xpc/periodictimer.hpp"        /* xpc::periodic_timer              */
+#include "xpc/timing.hpp"               /* xpc::microsleep(), microtime()   */
+#include "xpc/timingwheel.hpp"          /* xpc::timing_wheel                */
+#include "xpc/utilfunctions.hpp"        /* xpc::current_date_time()         */
+
+using clock_type = std::chrono::steady_clock;
+
+/**
+ *  Busy-waits, standing in for a cycle's processing.
+ */
+
+static void
+do_work (int us)
+{
+    auto until = clock_type::now() + std::chrono::microseconds(us);
+    while (clock_type::now() < until)
+    {
+        // spin
+    }
+}
+
+/*
+ *  Results of one drift case.  Times are in microseconds.
+ */
+
+struct drift_result
+{
+    long elapsed;
+    long expected;
+    long overruns;
+    long missed;
+};
+
+static void
+print_drift (const char * name, const drift_result & r)
+{
+    long behind = r.elapsed - r.expected;
+    std::printf
+    (
+        "%16s %12ld %12ld %12ld %9.3f%% %9ld %9ld\n",
+        name, r.expected, r.elapsed, behind,
+        r.expected > 0 ? 100.0 * double(behind) / double(r.expected) : 0.0,
+        r.overruns, r.missed
+    );
+}
+
+/*
+ *  Results of one accuracy case.  Lateness is in microseconds.
+ */
+
+struct accuracy_result
+{
+    double mean;
+    double p99;
+    double max;
+    double cpu_percent;
+};
+
+/**
+ *  Calls SLEEPER "samples" times, measuring how late each call returns.
+ */
+
+template <typename SLEEPER>
+static accuracy_result
+run_accuracy (int us, int samples, SLEEPER sleeper)
+{
+    std::vector<double> late;
+    late.reserve(samples);
+    std::clock_t c0 = std::clock();
+    auto w0 = clock_type::now();
+    for (int i = 0; i < samples; ++i)
+    {
+        auto t0 = clock_type::now();
+        sleeper(us);
+        auto t1 = clock_type::now();
+        std::chrono::duration<double, std::micro> actual = t1 - t0;
+        late.push_back(actual.count() - us);
+    }
+    std::chrono::duration<double> wall = clock_type::now() - w0;
+    double cpu = double(std::clock() - c0) / CLOCKS_PER_SEC;
+    std::sort(late.begin(), late.end());
+    double sum = 0.0;
+    for (double v : late)
+        sum += v;
+
+    return accuracy_result
+    {
+        sum / samples, late[(late.size() * 99) / 100], late.back(),
+        wall.count() > 0.0 ? 100.0 * cpu / wall.count() : 0.0
+    };
+}
+
+static void
+print_accuracy (int us, const char * name, const accuracy_result & r)
+{
+    std::printf
+    (
+        "%8d %20s %10.2f %10.2f %10.2f %8.1f%%\n",
+        us, name, r.mean, r.p99, r.max, r.cpu_percent
+    );
+}
+
+#if defined PLATFORM_LINUX
+
+/**
+ *  The microtime() of earlier versions, for comparison.
+ */
+
+static long
+legacy_microtime ()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec * 1000000) + (t.tv_nsec * 0.0010);
+}
+
+#endif
+
+/**
+ *  Gets the cost of one call of CLOCK, in nanoseconds.
+ */
+
+template <typename CLOCK>
+static double
+clock_cost (int calls, CLOCK clockfunc)
+{
+    volatile std::int64_t sink = 0;
+    std::int64_t t0 = xpc::nanotime();
+    for (int i = 0; i < calls; ++i)
+        sink = sink + std::int64_t(clockfunc());
+
+    std::int64_t t1 = xpc::nanotime();
+    (void) sink;
+    return double(t1 - t0) / calls;
+}
+
+/**
+ *  The callback for the timer cases; it counts the expirations.
+ */
+
+static void
+count_expiry (void * data)
+{
+    ++*static_cast<long *>(data);
+}
+
+/**
+ *  Runs the timer cases for "n" timers, with deadlines spread over one
+ *  second, in simulated time.
+ */
+
+static void
+run_timers (int n)
+{
+    std::vector<std::int64_t> offsets(n);
+    for (int i = 0; i < n; ++i)
+        offsets[i] = (std::int64_t(i) * 7919 % 1000) * 1000000 + 500000;
+
+    long expired = 0;
+    xpc::timing_wheel wheel(std::size_t(n), 1000);
+    std::vector<xpc::timing_wheel::timer_id> ids(n);
+    std::int64_t base = xpc::nanotime();
+    std::int64_t t0 = xpc::nanotime();
+    for (int i = 0; i < n; ++i)
+        ids[i] = wheel.schedule_at(base + offsets[i], count_expiry, &expired);
+
+    std::int64_t t1 = xpc::nanotime();
+    for (int i = 0; i < n; i += 2)
+        (void) wheel.cancel(ids[i]);
+
+    std::int64_t t2 = xpc::nanotime();
+    for (int i = 0; i < n; i += 2)
+        ids[i] = wheel.schedule_at(base + offsets[i], count_expiry, &expired);
+
+    std::int64_t t3 = xpc::nanotime();
+    for (int tick = 1; tick <= 1001; ++tick)
+        (void) wheel.advance(base + std::int64_t(tick) * 1000000);
+
+    std::int64_t t4 = xpc::nanotime();
+
+    long scanned = 0;
+    std::vector<std::int64_t> deadlines(n);
+    for (int i = 0; i < n; ++i)
+        deadlines[i] = base + offsets[i];
+
+    std::int64_t t5 = xpc::nanotime();
+    for (int tick = 1; tick <= 1001; ++tick)
+    {
+        std::int64_t now = base + std::int64_t(tick) * 1000000;
+        for (auto & d : deadlines)
+        {
+            if (d != 0 && d <= now)
+            {
+                d = 0;
+                count_expiry(&scanned);
+            }
+        }
+    }
+    std::int64_t t6 = xpc::nanotime();
+    std::printf
+    (
+        "%8d %12.1f %12.1f %14.1f %14.1f %8ld %8ld\n", n,
+        double(t1 - t0 + t3 - t2) / (n + n / 2), double(t2 - t1) / (n / 2),
+        double(t4 - t3) / 1001.0, double(t6 - t5) / 1001.0, expired, scanned
+    );
+}
+
+/*
+ * main() routine
+ */
+
+int
+main (int argc, char * argv [])
+{
+    int ticks = argc > 1 ? std::atoi(argv[1]) : 2000 ;
+    if (ticks <= 0)
+        ticks = 2000;
+
+    const int period_us = 1000;
+    const int work_us = 200;
+    std::printf
+    (
+        "Drift over %d ticks of %d us, %d us of work per tick\n\n"
+        "%16s %12s %12s %12s %10s %9s %9s\n",
+        ticks, period_us, work_us,
+        "pacing", "expected us", "elapsed us", "behind us", "error",
+        "overruns", "missed"
+    );
+
+    drift_result sleeper { 0, long(ticks) * period_us, 0, 0 };
+    long start = xpc::microtime();
+    for (int t = 0; t < ticks; ++t)
+    {
+        long t0 = xpc::microtime();
+        do_work(work_us);
+        long busy = xpc::microtime() - t0;
+        if (busy < period_us)
+            (void) xpc::microsleep(int(period_us - busy));
+    }
+    sleeper.elapsed = xpc::microtime() - start;
+    print_drift("microsleep()", sleeper);
+
+    drift_result timed { 0, long(ticks) * period_us, 0, 0 };
+    xpc::periodic_timer timer(period_us);
+    start = xpc::microtime();
+    timer.start();
+    for (int t = 0; t < ticks; ++t)
+    {
+        do_work(work_us);
+        (void) timer.wait();
+    }
+    timed.elapsed = xpc::microtime() - start;
+    timed.overruns = long(timer.overruns());
+    timed.missed = long(timer.missed_ticks());
+    print_drift("periodic_timer", timed);
+
+    int margin = xpc::calibrate_precise_sleep();
+    std::printf
+    (
+        "\nSleep accuracy, lateness in us, precise margin %d us\n\n"
+        "%8s %20s %10s %10s %10s %9s\n",
+        margin, "sleep us", "function", "mean", "p99", "max", "cpu"
+    );
+
+    const int lengths [] = { 50, 100, 500, 1000 };
+    for (int us : lengths)
+    {
+        int samples = 200000 / us;
+        print_accuracy
+        (
+            us, "microsleep()",
+            run_accuracy(us, samples, [] (int n) { xpc::microsleep(n); })
+        );
+        print_accuracy
+        (
+            us, "precise_microsleep()",
+            run_accuracy
+            (
+                us, samples, [] (int n) { xpc::precise_microsleep(n); }
+            )
+        );
+    }
+
+    long slack = xpc::timer_slack_ns();
+    std::printf
+    (
+        "\nTimer slack, microsleep() lateness in us\n\n"
+        "%8s %20s %10s %10s %10s %9s\n",
+        "sleep us", "slack ns", "mean", "p99", "max", "cpu"
+    );
+    for (int us : lengths)
+    {
+        char before[32];
+        char after[32];
+        int samples = 200000 / us;
+        auto sleeper = [] (int n) { xpc::microsleep(n); };
+        (void) std::snprintf(before, sizeof before, "%ld", slack);
+        print_accuracy(us, before, run_accuracy(us, samples, sleeper));
+        (void) xpc::set_timer_services(true);
+        (void) std::snprintf
+        (
+            after, sizeof after, "%ld", xpc::timer_slack_ns()
+        );
+        print_accuracy(us, after, run_accuracy(us, samples, sleeper));
+        (void) xpc::set_timer_services(false);
+    }
+    std::printf("\nSlack restored to %ld ns\n", xpc::timer_slack_ns());
+
+    const int calls = 2000000;
+    std::printf
+    (
+        "\nClock cost, ns per call, %d calls\n\n%32s %10s\n",
+        calls, "clock", "ns"
+    );
+    std::printf
+    (
+        "%32s %10.2f\n", "nanotime()",
+        clock_cost(calls, [] { return xpc::nanotime(); })
+    );
+    std::printf
+    (
+        "%32s %10.2f\n", "microtime()",
+        clock_cost(calls, [] { return xpc::microtime(); })
+    );
+    std::printf
+    (
+        "%32s %10.2f\n", "millitime()",
+        clock_cost(calls, [] { return xpc::millitime(); })
+    );
+    std::printf
+    (
+        "%32s %10.2f\n", "steady_clock::now()",
+        clock_cost
+        (
+            calls, []
+            {
+                return clock_type::now().time_since_epoch().count();
+            }
+        )
+    );
+    if (xpc::fastclock_init())
+    {
+        std::printf
+        (
+            "%32s %10.2f\n", "fastclock_ns() (TSC)",
+            clock_cost(calls, [] { return xpc::fastclock_ns(); })
+        );
+    }
+    else
+        std::printf("%32s %10s\n", "fastclock_ns() (TSC)", "n/a");
+
+    std::printf
+    (
+        "%32s %10.2f   (resolution %lld us)\n", "coarse_nanotime()",
+        clock_cost(calls, [] { return xpc::coarse_nanotime(); }),
+        (long long) xpc::coarse_resolution_ns() / 1000
+    );
+    (void) xpc::cached_clock::start();
+    std::printf
+    (
+        "%32s %10.2f\n", "cached_clock::nanotime()",
+        clock_cost(calls, [] { return xpc::cached_clock::nanotime(); })
+    );
+    xpc::cached_clock::stop();
+    std::printf
+    (
+        "%32s %10.2f\n", "current_date_time()",
+        clock_cost
+        (
+            calls / 10, [] { return xpc::current_date_time().size(); }
+        )
+    );
+#if defined PLATFORM_LINUX
+    std::printf
+    (
+        "%32s %10.2f\n", "old floating-point microtime()",
+        clock_cost(calls, [] { return legacy_microtime(); })
+    );
+#endif
+
+    std::printf
+    (
+        "\nTimers due within 1 s, 1 ms ticks, ns per operation\n\n"
+        "%8s %12s %12s %14s %14s %8s %8s\n",
+        "timers", "schedule", "cancel", "wheel/tick", "scan/tick",
+        "fired", "scanned"
+    );
+    for (int n = 1000; n <= 100000; n *= 10)
+        run_timers(n);
+
+    return EXIT_SUCCESS;
+}
+
+/*
+ * timing_benchmark.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
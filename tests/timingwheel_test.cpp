@@ -0,0 +1,339 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          timingwheel_test.cpp
+ *
+ *      Tests of the timing_wheel, driven by advance(now_ns).
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Every time is given as a tick from start_ns(), so the tests do not
+ *  depend on the real clock or on how fast they run.
+ *
+ *  Early: a timer is not run by an advance() to the nanosecond before the
+ *  start of its tick, and is run by one to that start.
+ *
+ *  Cancel: a cancelled timer never runs; a stale id does not cancel the
+ *  timer that reuses its pool entry.
+ *
+ *  Reschedule: a callback schedules itself again, several times within
+ *  one advance(), not early, and then stops.
+ *
+ *  Cascade: timers filed in levels 1, 2, and 3, some of them scheduled
+ *  from a callback part way along, each run in exactly their own tick,
+ *  in order, across the 256 and 65536 tick boundaries.
+ *
+ *  Pool: a full pool refuses a timer until one is cancelled or run.
+ */
+
+#include <cstdint>                      /* std::int64_t, std::uint64_t      */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/timingwheel.hpp"          /* xpc::timing_wheel                */
+
+static int s_failures = 0;
+
+/**
+ *  The tick given to the advance() that is running, set by step().
+ */
+
+static std::uint64_t s_tick = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+/**
+ *  The nanotime() of a tick's start.
+ */
+
+static std::int64_t
+tick_ns (const xpc::timing_wheel & wheel, std::uint64_t tick)
+{
+    return wheel.start_ns() + std::int64_t(tick) * wheel.tick_us() * 1000;
+}
+
+/**
+ *  Advances the wheel to a given time past the start of a tick.
+ */
+
+static int
+step (xpc::timing_wheel & wheel, std::uint64_t tick, std::int64_t offset = 0)
+{
+    s_tick = tick;
+    return wheel.advance(tick_ns(wheel, tick) + offset);
+}
+
+/**
+ *  A timer that records the ticks it runs in.
+ */
+
+struct recorder
+{
+    std::vector<std::uint64_t> ticks;
+};
+
+static void
+record (void * data)
+{
+    static_cast<recorder *>(data)->ticks.push_back(s_tick);
+}
+
+static void
+test_early ()
+{
+    xpc::timing_wheel wheel(16);
+    recorder exact;
+    recorder rounded;
+    (void) wheel.schedule_at(tick_ns(wheel, 5), record, &exact);
+    (void) wheel.schedule_at(tick_ns(wheel, 10) + 1, record, &rounded);
+    check(wheel.pending() == 2, "early: two timers pending");
+
+    check(step(wheel, 5, -1) == 0, "early: not run before its tick");
+    check(step(wheel, 5) == 1, "early: run at the start of its tick");
+    check
+    (
+        exact.ticks.size() == 1 && exact.ticks[0] == 5,
+        "early: runs once, in its tick"
+    );
+    check(step(wheel, 11, -1) == 0, "early: a deadline inside a tick waits");
+    check(step(wheel, 11) == 1, "early: ... for the next tick");
+    check(rounded.ticks.size() == 1, "early: runs once");
+    check(wheel.pending() == 0, "early: nothing left");
+}
+
+static void
+test_cancel ()
+{
+    xpc::timing_wheel wheel(1);
+    recorder cancelled;
+    recorder reused;
+    xpc::timing_wheel::timer_id id = wheel.schedule_at
+    (
+        tick_ns(wheel, 3), record, &cancelled
+    );
+    check(wheel.cancel(id), "cancel: pending timer is cancelled");
+    check(! wheel.cancel(id), "cancel: second cancel() fails");
+    check(wheel.pending() == 0, "cancel: nothing pending");
+
+    xpc::timing_wheel::timer_id newer = wheel.schedule_at
+    (
+        tick_ns(wheel, 3), record, &reused
+    );
+    check(newer != 0 && newer != id, "cancel: pool entry reused, new id");
+    check(! wheel.cancel(id), "cancel: stale id does not cancel it");
+    (void) step(wheel, 300);
+    check(cancelled.ticks.empty(), "cancel: cancelled timer never runs");
+    check(reused.ticks.size() == 1, "cancel: the newer timer runs");
+    check(! wheel.cancel(newer), "cancel: cannot cancel after running");
+}
+
+/**
+ *  A timer that schedules itself every "period" ticks until it has run
+ *  "limit" times.
+ */
+
+struct repeater
+{
+    xpc::timing_wheel * wheel;
+    std::uint64_t period;
+    int limit;
+    std::vector<std::uint64_t> ticks;
+};
+
+static void
+repeat (void * data)
+{
+    repeater * r = static_cast<repeater *>(data);
+    r->ticks.push_back(s_tick);
+    if (int(r->ticks.size()) < r->limit)
+    {
+        std::uint64_t next = r->ticks.size() * r->period;
+        (void) r->wheel->schedule_at(tick_ns(*r->wheel, next), repeat, r);
+    }
+}
+
+static void
+test_reschedule ()
+{
+    xpc::timing_wheel wheel(1);
+    repeater r { &wheel, 100, 5, { } };
+    (void) wheel.schedule_at(tick_ns(wheel, 0), repeat, &r);
+    check(step(wheel, 0) == 1, "reschedule: first run");
+    check(wheel.pending() == 1, "reschedule: it scheduled itself");
+    check(step(wheel, 350) == 3, "reschedule: runs again within advance()");
+    check(step(wheel, 399) == 0, "reschedule: not before the next period");
+    check(step(wheel, 400) == 1, "reschedule: last run");
+    check(step(wheel, 1000) == 0, "reschedule: then stops");
+    check(r.ticks.size() == 5 && wheel.pending() == 0, "reschedule: 5 runs");
+}
+
+/**
+ *  The ticks of the cascade test, in order.  Those marked "late" are
+ *  scheduled by the callback of the timer at tick 200, when the level-1
+ *  and level-2 slots they fall in are no longer the first ones.
+ */
+
+static const std::uint64_t c_cascade_ticks [] =
+{
+    1, 255, 256, 257, 300, 511, 512,
+    65535, 65536, 65537,
+    65600,                              /* late: level 1, slot 0            */
+    65791, 65792,
+    70000,                              /* late: level 1                    */
+    131072, 131073,
+    200000,                             /* late: level 2                    */
+    (std::uint64_t(1) << 24) + 7        /* level 3                          */
+};
+
+static const int c_cascade_count =
+    int(sizeof c_cascade_ticks / sizeof c_cascade_ticks[0]);
+
+static std::vector<recorder> s_cascade(c_cascade_count);
+
+static bool
+is_late (std::uint64_t tick)
+{
+    return tick == 65600 || tick == 70000 || tick == 200000;
+}
+
+/**
+ *  Schedules the cascade test's timers, either the late ones or the
+ *  others.
+ */
+
+static void
+schedule_cascade (xpc::timing_wheel & wheel, bool late)
+{
+    for (int i = 0; i < c_cascade_count; ++i)
+    {
+        std::uint64_t t = c_cascade_ticks[i];
+        if (is_late(t) == late)
+            (void) wheel.schedule_at(tick_ns(wheel, t), record, &s_cascade[i]);
+    }
+}
+
+static void
+schedule_late (void * data)
+{
+    schedule_cascade(*static_cast<xpc::timing_wheel *>(data), true);
+}
+
+static void
+test_cascade ()
+{
+    xpc::timing_wheel wheel(c_cascade_count + 1);
+    schedule_cascade(wheel, false);
+    (void) wheel.schedule_at(tick_ns(wheel, 200), schedule_late, &wheel);
+
+    bool early = false;
+    bool exact = true;
+    for (int i = 0; i < c_cascade_count; ++i)
+    {
+        std::uint64_t t = c_cascade_ticks[i];
+        (void) step(wheel, t - 1);
+        if (! s_cascade[i].ticks.empty())
+            early = true;
+
+        (void) step(wheel, t);
+        if (s_cascade[i].ticks.size() != 1 || s_cascade[i].ticks[0] != t)
+        {
+            std::printf("tick %llu: wrong\n", (unsigned long long) t);
+            exact = false;
+        }
+    }
+    check(! early, "cascade: no timer runs before its tick");
+    check(exact, "cascade: each timer runs once, in its own tick");
+    check(wheel.pending() == 0, "cascade: nothing left");
+}
+
+static void
+test_pool ()
+{
+    xpc::timing_wheel wheel(4);
+    recorder r;
+    std::vector<xpc::timing_wheel::timer_id> ids;
+    for (int i = 0; i < 4; ++i)
+        ids.push_back(wheel.schedule_at(tick_ns(wheel, 10 + i), record, &r));
+
+    check(ids.back() != 0, "pool: the last free timer is given out");
+    check(wheel.pending() == wheel.capacity(), "pool: all in use");
+    check
+    (
+        wheel.schedule_at(tick_ns(wheel, 20), record, &r) == 0,
+        "pool: full pool refuses a timer"
+    );
+    check
+    (
+        wheel.schedule_at(tick_ns(wheel, 20), nullptr, &r) == 0,
+        "pool: null callback refused"
+    );
+    check(wheel.cancel(ids[0]), "pool: cancel frees one");
+    check
+    (
+        wheel.schedule_at(tick_ns(wheel, 20), record, &r) != 0,
+        "pool: ... which can then be used"
+    );
+    check(step(wheel, 20) == 4, "pool: all run");
+    check(wheel.pending() == 0, "pool: all free again");
+
+    int refilled = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (wheel.schedule_at(tick_ns(wheel, 30), record, &r) != 0)
+            ++refilled;
+    }
+    check(refilled == 4, "pool: run timers are reused");
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+    test_early();
+    test_cancel();
+    test_reschedule();
+    test_cascade();
+    test_pool();
+    if (s_failures == 0)
+        std::printf("timingwheel_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * timingwheel_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
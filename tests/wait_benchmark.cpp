@@ -0,0 +1,432 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          wait_benchmark.cpp
+ *
+ *      A benchmark comparing the xpc66 wait/signal primitives.
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  Usage:
+ *
+ *      wait_benchmark [ round-trips ]
+ *
+ *  Ping-pong: two threads hand a token back and forth, each waking the
+ *  other and then waiting to be woken.  The time per round trip is two
+ *  wakeups.  This is done with a pair of synchronizers, a pair of
+ *  semaphores, and a pair of auto-reset events.
+ *
+ *  Uncontended: the cost of signalling when nobody waits, and of taking an
+ *  available count, on one thread.  A synchronizer::signal() with no
+ *  waiter, for a synchronizer with an atomic predicate, should cost no
+ *  more than the atomic load shown beside it plus a function call,
+ *  batching or not.  The default synchronizer still locks and notifies.
+ *
+ *  Producer/consumer: one thread counts 200000 items into a synchronizer's
+ *  atomic predicate state, signalling each one, and another waits and
+ *  takes whatever is there: with the default (locking) signal, and with
+ *  the atomic-predicate fast path, without and with batching.  This is a check
+ *  as well as a benchmark: a lost wakeup (a predicate not kept in
+ *  sequentially consistent atomics, say) hangs it, and a miscount fails
+ *  it.  The wakeups column shows how many waits batching saves.
+ *
+ *  Phase transitions: 2 to 16 threads pass through a barrier repeatedly,
+ *  with no work in between, so the time per phase is the cost of the
+ *  barrier itself.  This is done with a hand-made barrier (a counter and a
+ *  phase number under an xpc::condition, as phase boundaries are done
+ *  today) and with xpc::barrier.
+ */
+
+#include <atomic>                       /* std::atomic<bool>                */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdlib>                      /* EXIT_SUCCESS, std::atoi()        */
+#include <thread>                       /* std::thread                      */
+#include <vector>                       /* std::vector<>                    */
+
+#include "xpc/barrier.hpp"              /* xpc::barrier                     */
+#include "xpc/condition.hpp"            /* xpc::condition, synchronizer     */
+#include "xpc/semaphore.hpp"            /* xpc::semaphore, xpc::autoevent   */
+#include "xpc/timing.hpp"               /* xpc::microtime()                 */
+
+/*
+ *  A synchronizer whose predicate is a single seq_cst flag, so it may
+ *  (and by default does) opt in to the atomic-predicate fast path.
+ */
+
+class flag_synch : public xpc::synchronizer
+{
+
+public:
+
+    std::atomic<bool> m_ready { false };
+
+    explicit flag_synch (bool atomic_predicate = true) :
+        xpc::synchronizer   (atomic_predicate)
+    {
+        // no code
+    }
+
+    virtual bool predicate () const override
+    {
+        return m_ready.load();
+    }
+
+};
+
+/*
+ *  A synchronizer whose predicate is "items produced but not consumed".
+ *  Both counts are atomics written with the default (seq_cst) order, as
+ *  synchronizer::signal() requires.
+ */
+
+class counter_synch : public xpc::synchronizer
+{
+
+public:
+
+    std::atomic<long> m_produced { 0 };
+    std::atomic<long> m_consumed { 0 };
+
+    explicit counter_synch (bool atomic_predicate) :
+        xpc::synchronizer   (atomic_predicate)
+    {
+        // no code
+    }
+
+    virtual bool predicate () const override
+    {
+        return m_produced.load() != m_consumed.load();
+    }
+
+};
+
+/*
+ *  A barrier built by hand from an xpc::condition.
+ */
+
+class condition_barrier
+{
+
+private:
+
+    xpc::condition m_condition;
+    int m_count;
+    int m_arrived;
+    long m_phase;
+
+public:
+
+    explicit condition_barrier (int count) :
+        m_condition (),
+        m_count     (count),
+        m_arrived   (0),
+        m_phase     (0)
+    {
+        // no code
+    }
+
+    void arrive_and_wait ()
+    {
+        m_condition.lock();
+        long phase = m_phase;
+        if (++m_arrived == m_count)
+        {
+            m_arrived = 0;
+            ++m_phase;
+            m_condition.broadcast();
+        }
+        else
+            m_condition.wait([&] { return m_phase != phase; });
+
+        m_condition.unlock();
+    }
+
+};
+
+/**
+ *  Runs one phase-transition case.
+ *
+ * \return
+ *      Returns the nanoseconds per phase.
+ */
+
+template <typename BARRIER>
+static double
+phase_latency (BARRIER & b, int threadcount, int phases)
+{
+    std::vector<std::thread> threads;
+    long start = xpc::microtime();
+    for (int t = 0; t < threadcount; ++t)
+    {
+        threads.emplace_back
+        (
+            [&] ()
+            {
+                for (int p = 0; p < phases; ++p)
+                    b.arrive_and_wait();
+            }
+        );
+    }
+    for (auto & th : threads)
+        th.join();
+
+    long elapsed = xpc::microtime() - start;
+    return 1000.0 * double(elapsed) / double(phases);
+}
+
+/**
+ *  Runs the ping-pong.  WAKE(i) wakes side i (0 or 1), and WAIT(i) waits
+ *  on side i.
+ *
+ * \return
+ *      Returns the nanoseconds per round trip.
+ */
+
+template <typename WAKE, typename WAIT>
+static double
+ping_pong (int trips, WAKE wake, WAIT wait)
+{
+    std::thread pong
+    (
+        [&] ()
+        {
+            for (int i = 0; i < trips; ++i)
+            {
+                wait(1);
+                wake(0);
+            }
+        }
+    );
+    long start = xpc::microtime();
+    for (int i = 0; i < trips; ++i)
+    {
+        wake(1);
+        wait(0);
+    }
+    long elapsed = xpc::microtime() - start;
+    pong.join();
+    return 1000.0 * double(elapsed) / double(trips);
+}
+
+/**
+ *  Times a function on one thread.
+ *
+ * \return
+ *      Returns nanoseconds per call.
+ */
+
+template <typename FUNC>
+static double
+per_call (int count, FUNC f)
+{
+    long start = xpc::microtime();
+    for (int i = 0; i < count; ++i)
+        f();
+
+    long elapsed = xpc::microtime() - start;
+    return 1000.0 * double(elapsed) / double(count);
+}
+
+/**
+ *  Runs the producer/consumer check.
+ *
+ * \param atomic
+ *      If true, the synchronizer takes the atomic-predicate fast path.
+ *
+ * \param batch
+ *      The batch count for set_batching(), or 1 for no batching.
+ *
+ * \param [out] ns_per_item
+ *      The producer's time per item.
+ *
+ * \param [out] wakeups
+ *      The number of times the consumer's wait() returned.
+ *
+ * \return
+ *      Returns true if the consumer took exactly all of the items.
+ */
+
+static bool
+producer_consumer
+(
+    long items, bool atomic, int batch, double & ns_per_item, long & wakeups
+)
+{
+    counter_synch s(atomic);
+    if (batch > 1)
+        s.set_batching(batch, 200);
+
+    long taken = 0;
+    long waits = 0;
+    std::thread consumer
+    (
+        [&] ()
+        {
+            while (taken < items)
+            {
+                (void) s.wait();
+                ++waits;
+
+                long available = s.m_produced.load() - s.m_consumed.load();
+                taken += available;
+                s.m_consumed += available;
+            }
+        }
+    );
+    long start = xpc::microtime();
+    for (long i = 0; i < items; ++i)
+    {
+        ++s.m_produced;
+        s.signal();
+    }
+    s.flush();
+
+    long elapsed = xpc::microtime() - start;
+    consumer.join();
+    ns_per_item = 1000.0 * double(elapsed) / double(items);
+    wakeups = waits;
+    return taken == items && s.m_consumed.load() == items;
+}
+
+/*
+ * main() routine
+ */
+
+int
+main (int argc, char * argv [])
+{
+    int trips = argc > 1 ? std::atoi(argv[1]) : 100000 ;
+    if (trips <= 0)
+        trips = 100000;
+
+    flag_synch synchs[2];
+    double synch_ns = ping_pong
+    (
+        trips,
+        [&] (int i)
+        {
+            synchs[i].m_ready = true;
+            synchs[i].signal();
+        },
+        [&] (int i)
+        {
+            (void) synchs[i].wait();
+            synchs[i].m_ready = false;
+        }
+    );
+
+    xpc::semaphore sems[2];
+    double sem_ns = ping_pong
+    (
+        trips,
+        [&] (int i) { sems[i].post(); },
+        [&] (int i) { sems[i].wait(); }
+    );
+
+    xpc::autoevent events[2];
+    double event_ns = ping_pong
+    (
+        trips,
+        [&] (int i) { events[i].signal(); },
+        [&] (int i) { events[i].wait(); }
+    );
+
+    std::printf
+    (
+        "Ping-pong, %d round trips, ns per round trip\n\n"
+        "%14s %10.0f\n%14s %10.0f\n%14s %10.0f\n",
+        trips, "synchronizer", synch_ns, "semaphore", sem_ns,
+        "autoevent", event_ns
+    );
+
+    const int calls = 10000000;
+    flag_synch idle;
+    flag_synch idle_locking(false);
+    flag_synch idle_batched;
+    idle_batched.set_batching(16, 200);
+
+    std::atomic<int> word { 0 };
+    xpc::semaphore counter;
+    std::printf
+    (
+        "\nUncontended, ns per call\n\n"
+        "%32s %8.1f\n%32s %8.1f\n%32s %8.1f\n%32s %8.1f\n%32s %8.1f\n",
+        "atomic<int>::load()",
+        per_call(calls, [&] { (void) word.load(); }),
+        "synchronizer::signal(), default",
+        per_call(calls, [&] { idle_locking.signal(); }),
+        "synchronizer::signal(), atomic",
+        per_call(calls, [&] { idle.signal(); }),
+        "synchronizer::signal(), batched",
+        per_call(calls, [&] { idle_batched.signal(); }),
+        "semaphore::post() + wait()",
+        per_call(calls, [&] { counter.post(); counter.wait(); })
+    );
+
+    const long items = 200000;
+    std::printf
+    (
+        "\nProducer/consumer, %ld items\n\n%10s %8s %12s %12s\n",
+        items, "predicate", "batch", "ns/item", "wakeups"
+    );
+    for (int run = 0; run < 3; ++run)
+    {
+        bool atomic = run > 0;
+        int batch = run == 2 ? 16 : 1 ;
+        const char * kind = atomic ? "atomic" : "default" ;
+        double ns = 0.0;
+        long wakeups = 0;
+        if (! producer_consumer(items, atomic, batch, ns, wakeups))
+        {
+            std::printf("FAILED: items lost, %s, batch %d\n", kind, batch);
+            return EXIT_FAILURE;
+        }
+        std::printf("%10s %8d %12.1f %12ld\n", kind, batch, ns, wakeups);
+    }
+
+    int phases = trips / 4;
+    if (phases < 1)
+        phases = 1;                         /* phase_latency() divides by it */
+
+    std::printf
+    (
+        "\nPhase transitions, %d phases, ns per phase\n\n"
+        "%8s %12s %12s\n",
+        phases, "threads", "condition", "barrier"
+    );
+    for (int threadcount = 2; threadcount <= 16; threadcount *= 2)
+    {
+        condition_barrier cb(threadcount);
+        xpc::barrier xb(threadcount);
+        double cond_ns = phase_latency(cb, threadcount, phases);
+        double barrier_ns = phase_latency(xb, threadcount, phases);
+        std::printf("%8d %12.0f %12.0f\n", threadcount, cond_ns, barrier_ns);
+    }
+    return EXIT_SUCCESS;
+}
+
+/*
+ * wait_benchmark.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */
@@ -0,0 +1,198 @@
+/*
+ *  This file is part of xpc66.
+ *
+ *  xpc66 is free software; you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation; either version 2 of the License, or (at your option) any later
+ *  version.
+ *
+ *  xpc66 is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with xpc66; if not, write to the Free Software Foundation, Inc., 59 Temple
+ *  Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file          waitable_test.cpp
+ *
+ *      Tests of wait_any() and ring_buffer::wait_for_data().
+ *
+ * \library       xpc66
+ * \author        Chris Ahlstrom
+ * \date          2026-10-18
+ * \updates       2026-10-18
+ * \license       See above.
+ *
+ *  wait_any(): with no descriptor at all it fails at once, even with no
+ *  timeout, instead of blocking forever; a descriptor that has been closed
+ *  is an error (EBADF), not a wakeup; a timeout sets ETIMEDOUT; a signalled
+ *  notifier is reported by its index.
+ *
+ *  wait_for_data(): with a notifier, data pushed by another thread wakes
+ *  it; without one it still sees the data, and a stop wakes it at once.
+ */
+
+#include <cerrno>                       /* EBADF, ETIMEDOUT                 */
+#include <cstdio>                       /* std::printf()                    */
+#include <cstdint>                      /* std::int64_t                     */
+#include <cstdlib>                      /* EXIT_SUCCESS, EXIT_FAILURE       */
+#include <thread>                       /* std::thread                      */
+
+#include "platform_macros.h"            /* PLATFORM_UNIX                    */
+#include "xpc/notifier.hpp"             /* xpc::notifier                    */
+#include "xpc/ring_buffer.hpp"          /* xpc::ring_buffer<>               */
+#include "xpc/stoptoken.hpp"            /* xpc::stop_source                 */
+#include "xpc/timing.hpp"               /* xpc::nanotime(), millisleep()    */
+#include "xpc/waitable.hpp"             /* xpc::wait_any()                  */
+
+#if defined PLATFORM_UNIX
+#include <unistd.h>                     /* pipe(), close()                  */
+#endif
+
+static int s_failures = 0;
+
+static void
+check (bool ok, const char * what)
+{
+    if (! ok)
+    {
+        std::printf("FAILED: %s\n", what);
+        ++s_failures;
+    }
+}
+
+#if defined PLATFORM_UNIX
+
+/**
+ *  A waitable for any descriptor, to hand wait_any() a closed one.
+ */
+
+class fd_waitable : public xpc::waitable
+{
+
+public:
+
+    int m_fd = -1;
+
+    virtual int wait_fd () const override
+    {
+        return m_fd;
+    }
+
+};
+
+static void
+test_wait_any ()
+{
+    fd_waitable none;
+    std::int64_t t0 = xpc::nanotime();
+    int rc = xpc::wait_any({ nullptr, &none }, -1);
+    check(rc == -1 && errno == EBADF, "no descriptors: fails with EBADF");
+    check
+    (
+        xpc::nanotime() - t0 < 100000000,
+        "no descriptors: returns at once, not never"
+    );
+
+    int fds[2];
+    check(pipe(fds) == 0, "pipe()");
+    fd_waitable closed;
+    closed.m_fd = fds[0];
+    (void) close(fds[0]);
+    (void) close(fds[1]);
+    rc = xpc::wait_any({ &closed }, -1);
+    check(rc == -1 && errno == EBADF, "closed descriptor: EBADF");
+
+    xpc::notifier n;
+    rc = xpc::wait_any({ &none, &n }, 20);
+    check(rc == -1 && errno == ETIMEDOUT, "timeout: ETIMEDOUT");
+
+    n.signal();
+    rc = xpc::wait_any({ &none, &n }, -1);
+    check(rc == 1, "signalled notifier: its index");
+}
+
+#endif
+
+/**
+ *  Pushes one item after a delay, and times how long wait_for_data()
+ *  takes to see it.
+ */
+
+static std::int64_t
+data_delay_ns (xpc::ring_buffer<int> & rb, const xpc::stop_token & token)
+{
+    std::int64_t pushed = 0;
+    std::thread producer
+    (
+        [&rb, &pushed] ()
+        {
+            (void) xpc::millisleep(20);
+            pushed = xpc::nanotime();
+            (void) rb.push_back(1);
+        }
+    );
+    bool got = rb.wait_for_data(token, 2000);
+    std::int64_t seen = xpc::nanotime();
+    producer.join();
+    rb.pop_front();
+    return got ? seen - pushed : -1 ;
+}
+
+static void
+test_wait_for_data ()
+{
+    xpc::stop_source source;
+    xpc::ring_buffer<int> rb(16);
+    std::int64_t ns = data_delay_ns(rb, source.get_token());
+    check(ns >= 0 && ns < 50000000, "no notifier: data seen");
+
+    xpc::notifier n;
+    rb.attach(&n);
+    ns = data_delay_ns(rb, source.get_token());
+    check(ns >= 0 && ns < 50000000, "notifier: data seen");
+    std::printf("data seen %.3f ms after the push\n", ns / 1000000.0);
+
+    rb.attach(nullptr);
+    std::thread stopper
+    (
+        [&source] ()
+        {
+            (void) xpc::millisleep(20);
+            (void) source.request_stop();
+        }
+    );
+    std::int64_t t0 = xpc::nanotime();
+    bool got = rb.wait_for_data(source.get_token(), -1);
+    std::int64_t waited = xpc::nanotime() - t0;
+    stopper.join();
+    check(! got, "stop: no data");
+    check(waited < 500000000, "stop: wakes the wait");
+}
+
+/*
+ * main() routine
+ */
+
+int
+main ()
+{
+#if defined PLATFORM_UNIX
+    test_wait_any();
+#endif
+    test_wait_for_data();
+    if (s_failures == 0)
+        std::printf("waitable_test passed\n");
+
+    return s_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE ;
+}
+
+/*
+ * waitable_test.cpp
+ *
+ * vim: sw=4 ts=4 wm=4 et ft=cpp
+ */